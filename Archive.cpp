@@ -0,0 +1,507 @@
+// ---------------------- Project Includes ----------------------
+#include "Archive.h"
+#include "Simd.h"
+
+// ---------------------- System Includes ----------------------
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <array>
+
+// Note: Function documentations listed in header file
+
+/// @brief The first eight bytes of a version 2 file.
+static constexpr char s_headerMagic[8] = {'T', 'X', 'T', 'F', 'L', 'A', 'T', '\x1A'};
+
+/// @brief The last eight bytes of a version 2 file.
+static constexpr char s_footerMagic[8] = {'T', 'X', 'T', 'F', 'I', 'D', 'X', '\x1A'};
+
+/// @brief Where the checksum sits in the footer; the footer fields before it are part of what it covers.
+static constexpr size_t FooterCrcOffset = 32;
+
+/// @brief Stores a value as little-endian bytes.
+/// @param out Where to store it.
+/// @param value The value.
+/// @param bytes The number of bytes to store (4 or 8).
+static void storeLE(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i)
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+/// @brief Loads a value from little-endian bytes.
+/// @param in Where to load it from.
+/// @param bytes The number of bytes to load (4 or 8).
+/// @return The value.
+static uint64_t loadLE(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        value |= uint64_t(in[i]) << (8 * i);
+    return value;
+}
+
+/// @brief Reads and checks the header and footer of a file.
+/// @param header The first HeaderSize bytes of the file.
+/// @param footer The last FooterSize bytes of the file.
+/// @param fileSize The size of the file.
+/// @param index Receives the header fields, the text size and line count and room for every block.
+/// @return The file offset of the index.
+static uint64_t readEnds(const uint8_t* header, const uint8_t* footer, uint64_t fileSize, Archive::Index& index) {
+
+    // The magic numbers at both ends
+    if (std::memcmp(header, s_headerMagic, sizeof(s_headerMagic)) != 0)
+        throw std::runtime_error("Not a version 2 .bin file");
+    if (std::memcmp(footer + 40, s_footerMagic, sizeof(s_footerMagic)) != 0)
+        throw std::runtime_error("The .bin file is truncated or its index is damaged");
+
+    // The header fields
+    index.version = static_cast<uint32_t>(loadLE(header + 8, 4));
+    if (index.version != Archive::Version)
+        throw std::runtime_error("Unsupported .bin version: " + std::to_string(index.version));
+    index.blockSize = static_cast<uint32_t>(loadLE(header + 12, 4));
+    index.tableFingerprint = loadLE(header + 16, 8);
+
+    // The footer fields: the index must sit right before the footer
+    uint64_t indexOffset = loadLE(footer, 8);
+    uint64_t blockCount = loadLE(footer + 8, 8);
+    index.textBytes = loadLE(footer + 16, 8);
+    index.lineCount = loadLE(footer + 24, 8);
+    uint64_t indexEnd = fileSize - Archive::FooterSize;
+    if (indexOffset < Archive::HeaderSize || indexOffset > indexEnd ||
+        blockCount != (indexEnd - indexOffset) / Archive::IndexEntrySize ||
+        (indexEnd - indexOffset) % Archive::IndexEntrySize != 0)
+        throw std::runtime_error("The .bin file's index is damaged");
+
+    index.blocks.resize(static_cast<size_t>(blockCount));
+    return indexOffset;
+}
+
+/// @brief Reads and checks the index entries of a file.
+/// @param header The first HeaderSize bytes of the file.
+/// @param entries The index bytes.
+/// @param footer The last FooterSize bytes of the file.
+/// @param indexOffset The file offset of the index (where the block data ends).
+/// @param index Receives the blocks (already sized by readEnds()).
+static void readEntries(const uint8_t* header, const uint8_t* entries, const uint8_t* footer, uint64_t indexOffset, Archive::Index& index) {
+
+    // The header, index and footer fields must be exactly as written
+    uint32_t crc = Simd::crc32c(header, Archive::HeaderSize);
+    crc = Simd::crc32c(entries, index.blocks.size() * Archive::IndexEntrySize, crc);
+    if (Simd::crc32c(footer, FooterCrcOffset, crc) != static_cast<uint32_t>(loadLE(footer + FooterCrcOffset, 4)))
+        throw std::runtime_error("The .bin file's header or index is damaged (checksum mismatch)");
+
+    // Each block must lie inside the block data and pick up the text (and the line count) where the previous one
+    // left off: the first block starts at newline 0, and a block holds at most one newline per byte
+    uint64_t sourceOffset = 0;
+    uint64_t lineOffset = 0;
+    uint64_t lineLimit = 0;
+    uint64_t dataStart = Archive::HeaderSize;
+    for (Archive::Block& block : index.blocks) {
+        block.payloadOffset = loadLE(entries, 8);
+        block.sourceOffset = loadLE(entries + 8, 8);
+        block.sourceBytes = loadLE(entries + 16, 8);
+        block.bitCount = loadLE(entries + 24, 8);
+        block.lineOffset = loadLE(entries + 32, 8);
+        block.crc = static_cast<uint32_t>(loadLE(entries + 40, 4));
+        entries += Archive::IndexEntrySize;
+
+        uint64_t payloadBytes = block.bitCount / 8 + (block.bitCount % 8 != 0);
+        if (block.payloadOffset < dataStart + Archive::BlockHeaderSize || block.payloadOffset > indexOffset ||
+            payloadBytes > indexOffset - block.payloadOffset || block.sourceOffset != sourceOffset ||
+            block.lineOffset < lineOffset || block.lineOffset > lineLimit)
+            throw std::runtime_error("The .bin file's index is damaged");
+
+        dataStart = block.payloadOffset + payloadBytes;
+        sourceOffset += block.sourceBytes;
+        lineOffset = block.lineOffset;
+        lineLimit = block.lineOffset + block.sourceBytes;
+    }
+
+    // The blocks add up to the whole text, and the line count lies within the last block (0 without blocks)
+    if (sourceOffset != index.textBytes || index.lineCount < lineOffset || index.lineCount > lineLimit)
+        throw std::runtime_error("The .bin file's index is damaged");
+}
+
+bool Archive::isArchive(std::span<const uint8_t> data) {
+    return data.size() >= sizeof(s_headerMagic) && std::memcmp(data.data(), s_headerMagic, sizeof(s_headerMagic)) == 0;
+}
+
+Archive::Index Archive::readIndex(std::span<const uint8_t> file) {
+
+    // Too small for a header and a footer
+    if (file.size() < HeaderSize + FooterSize)
+        throw std::runtime_error("The .bin file is truncated");
+
+    // Everything is already in memory
+    Index index;
+    const uint8_t* footer = file.data() + file.size() - FooterSize;
+    uint64_t indexOffset = readEnds(file.data(), footer, file.size(), index);
+    readEntries(file.data(), file.data() + indexOffset, footer, indexOffset, index);
+    return index;
+}
+
+Archive::Index Archive::readIndex(std::istream& file) {
+
+    // Too small for a header and a footer
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    if (!file || fileSize < HeaderSize + FooterSize)
+        throw std::runtime_error("The .bin file is truncated");
+
+    // Read both ends
+    std::array<uint8_t, HeaderSize> header;
+    std::array<uint8_t, FooterSize> footer;
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(header.data()), HeaderSize);
+    file.seekg(static_cast<std::streamoff>(fileSize - FooterSize), std::ios::beg);
+    file.read(reinterpret_cast<char*>(footer.data()), FooterSize);
+    if (!file)
+        throw std::runtime_error("Could not read the .bin file's index");
+
+    // Then the index they point to
+    Index index;
+    uint64_t indexOffset = readEnds(header.data(), footer.data(), fileSize, index);
+    std::vector<uint8_t> entries(index.blocks.size() * IndexEntrySize);
+    file.seekg(static_cast<std::streamoff>(indexOffset), std::ios::beg);
+    file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size()));
+    if (!file)
+        throw std::runtime_error("Could not read the .bin file's index");
+    readEntries(header.data(), entries.data(), footer.data(), indexOffset, index);
+    return index;
+}
+
+void Archive::checkTable(const Index& index, const CompressionTable& table) {
+    if (index.tableFingerprint != table.fingerprint())
+        throw std::runtime_error("The .bin file was compressed with a different table");
+}
+
+void Archive::decodeBlock(const CompressionTable& table, const Block& block, const uint8_t* payload, char* out) {
+
+    // Damaged codes would decode to garbage (or not at all)
+    if (!checkBlock(block, payload))
+        throw std::runtime_error("A block of the .bin file is damaged (checksum mismatch at text offset " + std::to_string(block.sourceOffset) + ")");
+
+    // Decode in place while the decoder's overrun margin still fits inside the block's text
+    BitReader reader(payload, block.bitCount);
+    size_t length = static_cast<size_t>(block.sourceBytes);
+    size_t used = table.decode(reader, out, length);
+
+    // The last few symbols go through a scratch buffer, so nothing past the block's text is touched
+    thread_local std::string tail;
+    tail.clear();
+    table.decode(reader, tail);
+    if (used + tail.size() != length)
+        throw std::runtime_error("A block of the .bin file is damaged (decoded " + std::to_string(used + tail.size()) +
+                                 " bytes, expected " + std::to_string(length) + ")");
+    std::memcpy(out + used, tail.data(), tail.size());
+}
+
+void Archive::decodeBlocks(const CompressionTable& table, std::span<const Block> blocks, const uint8_t* data,
+                           uint64_t dataOffset, char* out, unsigned threads) {
+
+    // Nothing to decode
+    if (blocks.empty())
+        return;
+
+    // Each thread takes the next block not yet taken and decodes it into its own slice of the output;
+    // the first error stops the others from starting new blocks
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorLock;
+    uint64_t textStart = blocks.front().sourceOffset;
+    auto decode = [&]() {
+        for (size_t i = next++; i < blocks.size(); i = next++) {
+            try {
+                decodeBlock(table, blocks[i], data + (blocks[i].payloadOffset - dataOffset), out + (blocks[i].sourceOffset - textStart));
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error)
+                    error = std::current_exception();
+                next = blocks.size();
+            }
+        }
+    };
+
+    // This thread is one of the workers
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(threads, blocks.size()); ++t)
+        workers.emplace_back(decode);
+    decode();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // Report the first damaged block
+    if (error)
+        std::rethrow_exception(error);
+}
+
+bool Archive::checkBlock(const Block& block, const uint8_t* payload) {
+    return Simd::crc32c(payload, static_cast<size_t>((block.bitCount + 7) / 8)) == block.crc;
+}
+
+std::vector<size_t> Archive::verify(const Index& index, std::span<const uint8_t> file, unsigned threads) {
+
+    // Each thread takes the next block not yet taken and checks its header against the index and its codes against the checksum
+    std::vector<uint8_t> damaged(index.blocks.size(), 0);
+    std::atomic<size_t> next{0};
+    auto check = [&]() {
+        for (size_t i = next++; i < index.blocks.size(); i = next++) {
+            const Block& block = index.blocks[i];
+            const uint8_t* header = file.data() + block.payloadOffset - BlockHeaderSize;
+            damaged[i] = loadLE(header, 8) != block.sourceOffset || loadLE(header + 8, 8) != block.sourceBytes ||
+                         loadLE(header + 16, 8) != block.bitCount || loadLE(header + 24, 4) != block.crc ||
+                         !checkBlock(block, file.data() + block.payloadOffset);
+        }
+    };
+
+    // This thread is one of the workers
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(threads, index.blocks.size()); ++t)
+        workers.emplace_back(check);
+    check();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // List the damaged blocks in order
+    std::vector<size_t> result;
+    for (size_t i = 0; i < damaged.size(); ++i)
+        if (damaged[i])
+            result.push_back(i);
+    return result;
+}
+
+std::span<const Archive::Block> Archive::findBlocks(const Index& index, uint64_t offset, uint64_t length) {
+
+    // Clip the range to the text
+    offset = std::min(offset, index.textBytes);
+    uint64_t end = offset + std::min(length, index.textBytes - offset);
+    if (offset == end)
+        return {};
+
+    // The first block ending after the start, through the last block starting before the end
+    auto first = std::upper_bound(index.blocks.begin(), index.blocks.end(), offset,
+        [](uint64_t value, const Block& block) { return value < block.sourceOffset + block.sourceBytes; });
+    auto last = std::lower_bound(first, index.blocks.end(), end,
+        [](const Block& block, uint64_t value) { return block.sourceOffset < value; });
+    return std::span<const Block>(first, last);
+}
+
+uint64_t Archive::findLine(const CompressionTable& table, const Index& index, std::span<const uint8_t> file, uint64_t line) {
+
+    // The first line starts the text; a line past the last newline does not exist
+    uint64_t newline = line > 0 ? line - 1 : 0;
+    if (newline == 0)
+        return 0;
+    if (newline > index.lineCount)
+        return index.textBytes;
+
+    // The newline that ends the previous line is in the last block with fewer newlines before it
+    auto block = std::lower_bound(index.blocks.begin(), index.blocks.end(), newline,
+        [](const Block& block, uint64_t value) { return block.lineOffset < value; });
+    if (block == index.blocks.begin())
+        throw std::runtime_error("The .bin file's line index is damaged");
+    --block;
+
+    // Decode that block and count its newlines up to the one wanted
+    std::string text(static_cast<size_t>(block->sourceBytes), '\0');
+    decodeBlock(table, *block, file.data() + block->payloadOffset, text.data());
+    size_t pos = std::string::npos;
+    for (uint64_t seen = block->lineOffset; seen < newline; ++seen)
+        if ((pos = text.find('\n', pos + 1)) == std::string::npos)
+            throw std::runtime_error("The .bin file's line index is damaged");
+    return block->sourceOffset + pos + 1;
+}
+
+std::string Archive::decodeRange(const CompressionTable& table, const Index& index, std::span<const uint8_t> file,
+                                 uint64_t offset, uint64_t length, unsigned threads) {
+
+    // Decode just the blocks that hold the range
+    std::span<const Block> blocks = findBlocks(index, offset, length);
+    if (blocks.empty())
+        return std::string();
+    std::string text(static_cast<size_t>(blocks.back().sourceOffset + blocks.back().sourceBytes - blocks.front().sourceOffset), '\0');
+    decodeBlocks(table, blocks, file.data(), 0, text.data(), threads);
+
+    // Then cut the range out of them
+    uint64_t start = offset - blocks.front().sourceOffset;
+    text.erase(0, static_cast<size_t>(start));
+    text.resize(static_cast<size_t>(std::min<uint64_t>(length, text.size())));
+    return text;
+}
+
+// ****************** ArchiveWriter Implementation ******************
+
+ArchiveWriter::ArchiveWriter(const std::string& path, const CompressionTable& table, unsigned threads) :
+    m_table(&table), m_path(path), m_threads(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+
+    // Open the file
+    m_file.open(path, std::ios::out | std::ios::binary);
+    if (!m_file.is_open())
+        throw std::runtime_error("Could not open binary file for writing: " + path);
+
+    // Write the header
+    std::array<uint8_t, Archive::HeaderSize> header{};
+    std::memcpy(header.data(), s_headerMagic, sizeof(s_headerMagic));
+    storeLE(header.data() + 8, Archive::Version, 4);
+    storeLE(header.data() + 12, Archive::BlockSize, 4);
+    storeLE(header.data() + 16, table.fingerprint(), 8);
+    m_file.write(reinterpret_cast<const char*>(header.data()), Archive::HeaderSize);
+    m_fileOffset = Archive::HeaderSize;
+    m_headerCrc = Simd::crc32c(header.data(), header.size());
+
+    // One code buffer per block of a batch
+    m_encoded.resize(m_threads * Archive::BatchBlocks);
+    m_encodedBits.resize(m_threads * Archive::BatchBlocks);
+    m_encodedLines.resize(m_threads * Archive::BatchBlocks);
+    m_encodedCrcs.resize(m_threads * Archive::BatchBlocks);
+}
+
+void ArchiveWriter::write(std::string_view text) {
+
+    // Small pieces are gathered until there is a batch worth of text
+    size_t batchBytes = m_encoded.size() * Archive::BlockSize;
+    if (!m_pending.empty() || text.size() < batchBytes) {
+        m_pending.append(text);
+        if (m_pending.size() >= batchBytes)
+            m_pending.erase(0, writeBlocks(m_pending, false));
+        return;
+    }
+
+    // A large piece is encoded where it is; only what follows the last cut is held back
+    m_pending.assign(text.substr(writeBlocks(text, false)));
+}
+
+size_t ArchiveWriter::writeBlocks(std::string_view text, bool last) {
+    size_t used = 0;
+    while (true) {
+
+        // Cut off a batch of blocks while there is more than one block of text
+        m_batch.clear();
+        while (m_batch.size() < m_encoded.size() && text.size() - used > Archive::BlockSize) {
+
+            // After the last delimiter inside the block, or at its very end if it has none (the header records the
+            // block's exact length, so it can end mid-word)
+            std::string_view rest = text.substr(used);
+            size_t pos = rest.find_last_of(" \n", Archive::BlockSize - 1);
+            if (pos == std::string_view::npos)
+                pos = Archive::BlockSize - 1;
+
+            m_batch.push_back(rest.substr(0, pos + 1));
+            used += pos + 1;
+        }
+
+        // At the end, whatever is left is the last block
+        bool full = m_batch.size() == m_encoded.size();
+        if (!full && last && used < text.size()) {
+            m_batch.push_back(text.substr(used));
+            used = text.size();
+        }
+
+        // Encode the batch in parallel, then write it in order
+        encodeBlocks(m_batch);
+        for (size_t i = 0; i < m_batch.size(); ++i)
+            writeBlock(m_batch[i], m_encoded[i], m_encodedBits[i], m_encodedLines[i], m_encodedCrcs[i]);
+
+        // Go on only if the batch was cut short by its size, not by the text
+        if (!full)
+            return used;
+    }
+}
+
+void ArchiveWriter::encodeBlocks(std::span<const std::string_view> blocks) {
+
+    // Each thread takes the next block not yet taken, so uneven blocks even out
+    std::atomic<size_t> next{0};
+    auto encode = [this, blocks, &next]() {
+        for (size_t i = next++; i < blocks.size(); i = next++) {
+            m_encoded[i].clear();
+            BitWriter writer(m_encoded[i]);
+            m_table->encodeText(blocks[i], writer);
+            writer.flush();
+            m_encodedBits[i] = writer.bitCount();
+            m_encodedLines[i] = static_cast<uint64_t>(std::count(blocks[i].begin(), blocks[i].end(), '\n'));
+            m_encodedCrcs[i] = Simd::crc32c(m_encoded[i].bytes(), m_encoded[i].byteSize());
+        }
+    };
+
+    // This thread is one of the workers
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(m_threads, blocks.size()); ++t)
+        workers.emplace_back(encode);
+    encode();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ArchiveWriter::writeBlock(std::string_view text, const BitBuffer& packed, uint64_t bitCount, uint64_t lines, uint32_t crc) {
+
+    // Record it
+    Archive::Block block;
+    block.payloadOffset = m_fileOffset + Archive::BlockHeaderSize;
+    block.sourceOffset = m_stats.textBytes;
+    block.sourceBytes = text.size();
+    block.bitCount = bitCount;
+    block.lineOffset = m_lineCount;
+    block.crc = crc;
+    m_blocks.push_back(block);
+
+    // Write its header, then its codes
+    std::array<uint8_t, Archive::BlockHeaderSize> header{};
+    storeLE(header.data(), block.sourceOffset, 8);
+    storeLE(header.data() + 8, block.sourceBytes, 8);
+    storeLE(header.data() + 16, block.bitCount, 8);
+    storeLE(header.data() + 24, block.crc, 4);
+    m_file.write(reinterpret_cast<const char*>(header.data()), Archive::BlockHeaderSize);
+    m_file.write(reinterpret_cast<const char*>(packed.bytes()), static_cast<std::streamsize>(packed.byteSize()));
+
+    m_fileOffset = block.payloadOffset + packed.byteSize();
+    m_stats.textBytes += block.sourceBytes;
+    m_stats.payloadBits += block.bitCount;
+    m_lineCount += lines;
+}
+
+ArchiveWriter::Stats ArchiveWriter::finish() {
+
+    // The held-back text makes up the last blocks
+    writeBlocks(m_pending, true);
+    m_pending.clear();
+
+    // Write the index
+    std::vector<uint8_t> index(m_blocks.size() * Archive::IndexEntrySize, 0);
+    uint8_t* entry = index.data();
+    for (const Archive::Block& block : m_blocks) {
+        storeLE(entry, block.payloadOffset, 8);
+        storeLE(entry + 8, block.sourceOffset, 8);
+        storeLE(entry + 16, block.sourceBytes, 8);
+        storeLE(entry + 24, block.bitCount, 8);
+        storeLE(entry + 32, block.lineOffset, 8);
+        storeLE(entry + 40, block.crc, 4);
+        entry += Archive::IndexEntrySize;
+    }
+    m_file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+
+    // Then the footer that points at it
+    std::array<uint8_t, Archive::FooterSize> footer{};
+    storeLE(footer.data(), m_fileOffset, 8);
+    storeLE(footer.data() + 8, m_blocks.size(), 8);
+    storeLE(footer.data() + 16, m_stats.textBytes, 8);
+    storeLE(footer.data() + 24, m_lineCount, 8);
+    uint32_t crc = Simd::crc32c(index.data(), index.size(), m_headerCrc);
+    storeLE(footer.data() + FooterCrcOffset, Simd::crc32c(footer.data(), FooterCrcOffset, crc), 4);
+    std::memcpy(footer.data() + 40, s_footerMagic, sizeof(s_footerMagic));
+    m_file.write(reinterpret_cast<const char*>(footer.data()), Archive::FooterSize);
+
+    // Make sure everything reached the disk
+    m_file.close();
+    if (m_file.fail())
+        throw std::runtime_error("Could not write binary file: " + m_path);
+
+    return m_stats;
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <string_view>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <span>
+
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+#include "BitStream.h"
+
+/// @brief Static helpers for the block-indexed .bin container, version 2 (Don't create an object!)
+/// @note Layout (every integer little-endian):
+/// @note   Header: magic "TXTFLAT\x1A", version, nominal block size, table fingerprint, reserved (32 bytes)
+/// @note   Blocks: source offset, source bytes, bit count, CRC-32C of the code bytes, reserved (32 bytes),
+/// @note           then the block's code bytes (MSB first)
+/// @note   Index:  per block its payload offset, source offset, source bytes, bit count, the number of newlines
+/// @note           before it, CRC-32C of its code bytes and reserved (48 bytes each)
+/// @note   Footer: index offset, block count, text bytes, line count (newlines), CRC-32C of the header, index and
+/// @note           the footer fields before it, reserved, magic "TXTFIDX\x1A" (48 bytes)
+/// @note Every block is the encoding of its own slice of text (cut after a space or newline, or at the block size
+/// @note where there is none) and is padded to a whole byte, so it can be decoded on its own. Legacy files start
+/// @note with their bit count, which can never equal the magic read as a number (that would be a file of petabytes).
+/// @note The index doubles as a seek index: any byte or line range is found in it and decoded from its blocks alone.
+class Archive {
+    public:
+
+        /// @brief The format version written.
+        static constexpr uint32_t Version = 2;
+
+        /// @brief The most (normalized) text a block holds.
+        static constexpr size_t BlockSize = size_t(64) << 10;
+
+        /// @brief The number of blocks each thread is given per batch, when a file is encoded or decoded in batches.
+        static constexpr size_t BatchBlocks = 8;
+
+        /// @brief The sizes of the fixed parts of the file.
+        static constexpr size_t HeaderSize = 32;
+        static constexpr size_t BlockHeaderSize = 32;
+        static constexpr size_t IndexEntrySize = 48;
+        static constexpr size_t FooterSize = 48;
+
+        /// @brief Where a block is and what it holds.
+        struct Block {
+            uint64_t payloadOffset = 0;  // File offset of the block's code bytes
+            uint64_t sourceOffset = 0;   // Offset of the block's text in the whole (normalized) text
+            uint64_t sourceBytes = 0;    // Length of the block's text
+            uint64_t bitCount = 0;       // Number of valid bits in the block's code bytes
+            uint64_t lineOffset = 0;     // Number of newlines in the text before the block
+            uint32_t crc = 0;            // CRC-32C of the block's code bytes
+        };
+
+        /// @brief Everything the header, index and footer say about a file.
+        struct Index {
+            uint32_t version = 0;
+            uint32_t blockSize = 0;
+            uint64_t tableFingerprint = 0;
+            uint64_t textBytes = 0;
+            uint64_t lineCount = 0;      // Number of newlines in the whole text
+            std::vector<Block> blocks;
+        };
+
+        /// @brief Checks whether bytes start like a version 2 file.
+        /// @param data The first bytes of the file.
+        /// @return True if they begin with the header magic.
+        static bool isArchive(std::span<const uint8_t> data);
+
+        /// @brief Reads and checks the index of a file held in memory.
+        /// @param file The whole file.
+        /// @return The index.
+        /// @note Throws if the header, index or footer is damaged (including a checksum mismatch), or if a block lies
+        /// @note outside the file. The blocks themselves are not read.
+        static Index readIndex(std::span<const uint8_t> file);
+
+        /// @brief Reads and checks the index of a file on disk, without reading the blocks.
+        /// @param file The open file (its read position is left undefined).
+        /// @return The index.
+        /// @note Throws like readIndex() on memory.
+        static Index readIndex(std::istream& file);
+
+        /// @brief Makes sure a file was written with a table.
+        /// @param index The file's index.
+        /// @param table The table about to decode it.
+        /// @note Throws if the fingerprints differ (the output would be garbage).
+        static void checkTable(const Index& index, const CompressionTable& table);
+
+        /// @brief Decodes a block straight into its place in the output.
+        /// @param table The table to decode with (in Decompress mode).
+        /// @param block The block.
+        /// @param payload The block's code bytes (at least (bitCount + 7) / 8 of them).
+        /// @param out Where the block's text goes (room for exactly sourceBytes).
+        /// @note Throws if the block's checksum does not match or it does not decode to exactly its source bytes.
+        /// @note Nothing outside out is written.
+        static void decodeBlock(const CompressionTable& table, const Block& block, const uint8_t* payload, char* out);
+
+        /// @brief Decodes consecutive blocks in parallel, each straight into its place in the output.
+        /// @param table The table to decode with (in Decompress mode).
+        /// @param blocks The blocks.
+        /// @param data Bytes of the file holding every block's code bytes.
+        /// @param dataOffset The file offset of data[0].
+        /// @param out Where the blocks' text goes (room for all of it; the first block's text goes first).
+        /// @param threads The number of threads to decode with (0 for one per core).
+        /// @note Throws (once every thread is done) if any block is damaged.
+        static void decodeBlocks(const CompressionTable& table, std::span<const Block> blocks, const uint8_t* data,
+                                 uint64_t dataOffset, char* out, unsigned threads);
+
+        /// @brief Checks a block's code bytes against its checksum.
+        /// @param block The block.
+        /// @param payload The block's code bytes.
+        /// @return True if they are intact.
+        static bool checkBlock(const Block& block, const uint8_t* payload);
+
+        /// @brief Checks every block of a file without decoding any.
+        /// @param index The file's index (readIndex() has already checked the header and index).
+        /// @param file The whole file.
+        /// @param threads The number of threads to check with (0 for one per core).
+        /// @return The positions in index.blocks of the blocks whose header or checksum does not match (none if intact).
+        static std::vector<size_t> verify(const Index& index, std::span<const uint8_t> file, unsigned threads = 0);
+
+        /// @brief Finds the blocks that hold a range of the text.
+        /// @param index The file's index.
+        /// @param offset The start of the range.
+        /// @param length The length of the range.
+        /// @return The consecutive blocks covering [offset, offset + length), clipped to the text (empty if nothing is left).
+        static std::span<const Block> findBlocks(const Index& index, uint64_t offset, uint64_t length);
+
+        /// @brief Finds where a line starts, decoding at most one block.
+        /// @param table The table to decode with (in Decompress mode).
+        /// @param index The file's index.
+        /// @param file The whole file.
+        /// @param line The line number (1 is the first line).
+        /// @return The text offset of the line's first byte (the text size if there is no such line).
+        static uint64_t findLine(const CompressionTable& table, const Index& index, std::span<const uint8_t> file, uint64_t line);
+
+        /// @brief Decodes a range of the text, decoding only the blocks that hold it.
+        /// @param table The table to decode with (in Decompress mode).
+        /// @param index The file's index.
+        /// @param file The whole file.
+        /// @param offset The start of the range.
+        /// @param length The length of the range (clipped to the text).
+        /// @param threads The number of threads to decode with (0 for one per core).
+        /// @return The text in the range.
+        static std::string decodeRange(const CompressionTable& table, const Index& index, std::span<const uint8_t> file,
+                                       uint64_t offset, uint64_t length, unsigned threads = 0);
+};
+
+/// @brief This class writes a version 2 .bin file a piece of text at a time.
+/// @note Text is cut into blocks of at most Archive::BlockSize, after the last space or newline in them (or right
+/// @note at Archive::BlockSize if they have none); whatever follows the last cut waits for the next piece (or
+/// @note finish()), so the blocks do not depend on how the text was fed in.
+/// @note Blocks are encoded a batch at a time on a pool of threads sharing the (read-only) table, then written
+/// @note in order, so the file is the same whatever the number of threads.
+class ArchiveWriter {
+public:
+
+    /// @brief What was written.
+    struct Stats {
+        uint64_t textBytes = 0;    // Bytes of text encoded
+        uint64_t payloadBits = 0;  // Bits of compressed payload (without the container)
+    };
+
+    /// @brief The constructor for ArchiveWriter. Writes the header.
+    /// @param path The .bin file to write.
+    /// @param table The table to encode with (in Compress mode). It must outlive the writer.
+    /// @param threads The number of threads to encode with (0 for one per core).
+    /// @note Throws if the file cannot be opened.
+    ArchiveWriter(const std::string& path, const CompressionTable& table, unsigned threads = 0);
+
+    /// @brief Encodes more text.
+    /// @param text The next piece of (normalized) text.
+    void write(std::string_view text);
+
+    /// @brief Encodes the held-back text and writes the index and footer.
+    /// @return What was written.
+    /// @note Throws if the file could not be written.
+    Stats finish();
+
+private:
+
+    /// @brief Cuts text into blocks, encodes them and writes them out.
+    /// @param text The text.
+    /// @param last Whether this is the end of the text (the rest after the last cut is a block too).
+    /// @return The number of bytes written as blocks; the rest is to be held back.
+    size_t writeBlocks(std::string_view text, bool last);
+
+    /// @brief Encodes blocks in parallel into m_encoded.
+    /// @param blocks The blocks' texts.
+    void encodeBlocks(std::span<const std::string_view> blocks);
+
+    /// @brief Writes out an encoded block.
+    /// @param text The block's text.
+    /// @param packed The block's codes.
+    /// @param bitCount The number of valid bits in packed.
+    /// @param lines The number of newlines in text.
+    /// @param crc The checksum of packed's bytes.
+    void writeBlock(std::string_view text, const BitBuffer& packed, uint64_t bitCount, uint64_t lines, uint32_t crc);
+
+    /// @brief The table being encoded with.
+    const CompressionTable *m_table;
+
+    /// @brief The file being written and its path.
+    std::ofstream m_file;
+    std::string m_path;
+
+    /// @brief Text after the last cut, waiting for more.
+    std::string m_pending;
+
+    /// @brief The blocks written so far.
+    std::vector<Archive::Block> m_blocks;
+
+    /// @brief The number of threads encoding.
+    unsigned m_threads;
+
+    /// @brief The blocks of the current batch.
+    std::vector<std::string_view> m_batch;
+
+    /// @brief The codes of each block of the current batch, their bit counts, the newlines in each block's text
+    /// @brief and the codes' checksums (reused from batch to batch).
+    std::vector<BitBuffer> m_encoded;
+    std::vector<uint64_t> m_encodedBits;
+    std::vector<uint64_t> m_encodedLines;
+    std::vector<uint32_t> m_encodedCrcs;
+
+    /// @brief The number of bytes written to the file so far.
+    uint64_t m_fileOffset = 0;
+
+    /// @brief What has been written so far.
+    Stats m_stats;
+
+    /// @brief The number of newlines written so far.
+    uint64_t m_lineCount = 0;
+
+    /// @brief The checksum of the header (the index's and footer's checksum continues it).
+    uint32_t m_headerCrc = 0;
+};
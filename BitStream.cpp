@@ -0,0 +1,19 @@
+// ---------------------- Project Includes ----------------------
+#include "BitStream.h"
+
+// ****************** BitWriter Implementation ******************
+
+void BitWriter::flush() {
+
+    // Nothing pending
+    if (m_accBits == 0)
+        return;
+
+    // Left-align the pending bits so they start at the word's most significant bit
+    m_sink->m_words.push_back(toBigEndian(m_acc << (64 - m_accBits)));
+    m_sink->m_size += m_accBits;
+
+    // Reset the accumulator
+    m_acc = 0;
+    m_accBits = 0;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <bit>
+
+/// @brief Converts a 64-bit word between native and big-endian byte order.
+/// @param word The word to convert.
+/// @return The converted word (unchanged on big-endian machines).
+inline uint64_t toBigEndian(uint64_t word) {
+    if constexpr (std::endian::native == std::endian::big)
+        return word;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(word);
+#else
+    word = ((word & 0x00FF00FF00FF00FFull) << 8)  | ((word >> 8)  & 0x00FF00FF00FF00FFull);
+    word = ((word & 0x0000FFFF0000FFFFull) << 16) | ((word >> 16) & 0x0000FFFF0000FFFFull);
+    return (word << 32) | (word >> 32);
+#endif
+}
+
+/// @brief This class represents a growable sequence of bits packed into 64-bit words.
+/// @note Words are stored big-endian so the raw bytes are the bits in order, MSB first (the .bin payload layout).
+class BitBuffer {
+public:
+
+    /// @brief Gets the number of valid bits.
+    /// @return The number of bits stored.
+    uint64_t size() const { return m_size; }
+
+    /// @brief Gets the number of bytes needed to hold every valid bit.
+    /// @return The number of (possibly partial) bytes.
+    size_t byteSize() const { return static_cast<size_t>((m_size + 7) / 8); }
+
+    /// @brief Gets the packed bytes, MSB first.
+    /// @return A pointer to the first byte (valid until the buffer grows).
+    const uint8_t* bytes() const { return reinterpret_cast<const uint8_t*>(m_words.data()); }
+
+    /// @brief Gets the packed bytes for filling them in place (e.g. straight from a file).
+    /// @return A pointer to the first byte (valid until the buffer grows).
+    uint8_t* bytes() { return reinterpret_cast<uint8_t*>(m_words.data()); }
+
+    /// @brief Gets a single bit.
+    /// @param index The index of the bit (must be less than size()).
+    /// @return The value of the bit.
+    bool operator[](uint64_t index) const { return (bytes()[index >> 3] >> (7 - (index & 7))) & 1u; }
+
+    /// @brief Removes every bit (keeps the capacity).
+    void clear() { m_words.clear(); m_size = 0; }
+
+    /// @brief Resizes the buffer to a number of bits; new bits are zero.
+    /// @param bits The new number of valid bits.
+    /// @note Bits past the end of the last byte are not cleared when shrinking.
+    void resize(uint64_t bits) { m_words.resize(static_cast<size_t>((bits + 63) / 64), 0); m_size = bits; }
+
+    /// @brief Reserves room for a number of bits.
+    /// @param bits The number of bits to make room for.
+    void reserve(uint64_t bits) { m_words.reserve(static_cast<size_t>((bits + 63) / 64)); }
+
+private:
+
+    /// @brief The BitWriter appends whole words directly.
+    friend class BitWriter;
+
+    /// @brief The packed words (big-endian).
+    std::vector<uint64_t> m_words;
+
+    /// @brief The number of valid bits in m_words.
+    uint64_t m_size = 0;
+};
+
+/// @brief This class appends codes to a BitBuffer through a 64-bit accumulator.
+/// @note Only whole words reach the sink until flush() is called, so appending never touches single bits.
+class BitWriter {
+public:
+
+    /// @brief The constructor for BitWriter.
+    /// @param sink The buffer to append to. Its size must be a multiple of 64 bits (e.g. empty).
+    explicit BitWriter(BitBuffer& sink) : m_sink(&sink) {}
+
+    /// @brief Appends a code.
+    /// @param bits The code, right-aligned (bits above `length` must be 0).
+    /// @param length The number of bits in the code (0 to 32).
+    void put(uint32_t bits, uint8_t length) {
+        m_count += length;
+
+        // Common case: the code still fits in the accumulator
+        if (m_accBits + length < 64) {
+            m_acc = (m_acc << length) | bits;
+            m_accBits += length;
+            return;
+        }
+
+        // Otherwise top off the accumulator, hand the full word to the sink and keep the remainder
+        // (m_accBits >= 32 here, so neither shift below can reach 64)
+        unsigned room = 64 - m_accBits;
+        unsigned rest = length - room;
+        m_sink->m_words.push_back(toBigEndian((m_acc << room) | (static_cast<uint64_t>(bits) >> rest)));
+        m_sink->m_size += 64;
+        m_acc = bits & ((uint64_t(1) << rest) - 1);
+        m_accBits = rest;
+    }
+
+    /// @brief Gets the number of bits appended so far (including those still in the accumulator).
+    /// @return The number of bits written through this writer.
+    uint64_t bitCount() const { return m_count; }
+
+    /// @brief Moves the bits still in the accumulator into the sink, zero padding the last word.
+    /// @note Call this once, after the last put().
+    void flush();
+
+private:
+
+    /// @brief The buffer whole words are appended to.
+    BitBuffer *m_sink;
+
+    /// @brief The pending bits, right-aligned.
+    uint64_t m_acc = 0;
+
+    /// @brief The number of pending bits in m_acc (always less than 64).
+    unsigned m_accBits = 0;
+
+    /// @brief The total number of bits appended.
+    uint64_t m_count = 0;
+};
+
+/// @brief This class reads bits (MSB first) from packed bytes without copying them.
+/// @note Reads past the end yield zero bits; use remaining() to know how many bits are real.
+class BitReader {
+public:
+
+    /// @brief The constructor for BitReader.
+    /// @param data The packed bytes, MSB first.
+    /// @param bitCount The number of valid bits in data.
+    BitReader(const uint8_t* data, uint64_t bitCount) :
+        m_data(data), m_byteCount(static_cast<size_t>((bitCount + 7) / 8)), m_size(bitCount) {}
+
+    /// @brief The constructor for BitReader over a BitBuffer.
+    /// @param buffer The buffer to read. It must outlive the reader and not grow while reading.
+    explicit BitReader(const BitBuffer& buffer) : BitReader(buffer.bytes(), buffer.size()) {}
+
+    /// @brief Gets the index of the next bit to be read.
+    /// @return The current bit position.
+    uint64_t position() const { return m_pos; }
+
+    /// @brief Gets the number of valid bits left to read.
+    /// @return The remaining bit count.
+    uint64_t remaining() const { return m_size - m_pos; }
+
+    /// @brief Looks at the next bits without consuming them.
+    /// @param count The number of bits to look at (1 to 32).
+    /// @return The bits, right-aligned.
+    uint32_t peek(unsigned count) const {
+        return static_cast<uint32_t>((load(static_cast<size_t>(m_pos >> 3)) << (m_pos & 7)) >> (64 - count));
+    }
+
+    /// @brief Consumes bits.
+    /// @param count The number of bits to consume.
+    void skip(unsigned count) { m_pos += count; }
+
+    /// @brief Reads and consumes the next bits.
+    /// @param count The number of bits to read (1 to 32).
+    /// @return The bits, right-aligned.
+    uint32_t read(unsigned count) { uint32_t bits = peek(count); skip(count); return bits; }
+
+private:
+
+    /// @brief Loads the 8 bytes starting at a byte index as a big-endian word (zero filled past the end).
+    /// @param index The byte index.
+    /// @return The loaded word.
+    uint64_t load(size_t index) const {
+        uint64_t word = 0;
+        if (index + 8 <= m_byteCount)
+            std::memcpy(&word, m_data + index, 8);
+        else if (index < m_byteCount)
+            std::memcpy(&word, m_data + index, m_byteCount - index);
+        return toBigEndian(word);
+    }
+
+    /// @brief The packed bytes being read.
+    const uint8_t *m_data;
+
+    /// @brief The number of bytes in m_data.
+    size_t m_byteCount;
+
+    /// @brief The number of valid bits in m_data.
+    uint64_t m_size;
+
+    /// @brief The index of the next bit to read.
+    uint64_t m_pos = 0;
+};
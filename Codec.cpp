@@ -0,0 +1,226 @@
+// ---------------------- Project Includes ----------------------
+#include "Codec.h"
+#include "Archive.h"
+
+// ---------------------- System Includes ----------------------
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <span>
+
+// Note: Function documentations listed in header file
+
+/// @brief Checks whether normalizing a window in two pieces, split at a position, matches normalizing it whole.
+/// @param window The raw (not yet normalized) text.
+/// @param pos The split position (greater than 0).
+/// @return False if the bytes before pos could still be changed by the bytes after it.
+static bool isNeutralCut(const std::string& window, size_t pos) {
+
+    // A possible start of a multi-byte sequence
+    unsigned char last = static_cast<unsigned char>(window[pos - 1]);
+    if (last == 0xE2 || last == 0xC3 || last == 0xC2)
+        return false;
+    if (last == 0x80 && pos >= 2 && static_cast<unsigned char>(window[pos - 2]) == 0xE2)
+        return false;
+
+    // A '\r' whose line ending is still undecided (zero-width spaces between it and a '\n' are dropped)
+    size_t end = pos;
+    while (end >= 3 && window.compare(end - 3, 3, "\xE2\x80\x8B") == 0)
+        end -= 3;
+    return !(end >= 1 && window[end - 1] == '\r');
+}
+
+/// @brief Finds where a window of raw text can be cut without splitting anything that matters.
+/// @param window The raw (not yet normalized) text.
+/// @return The number of bytes to process now (0 if none); the rest is carried over to the next window.
+/// @note Prefers cutting after the last space or newline so no word straddles the cut. Failing that, cuts at
+/// @note the last position no normalization sequence or line ending straddles.
+static size_t findSafeCut(const std::string& window) {
+
+    // After the last word delimiter
+    size_t pos = window.find_last_of(" \n");
+    if (pos != std::string::npos)
+        return pos + 1;
+
+    // The last neutral position
+    for (size_t i = window.size(); i > 0; --i)
+        if (isNeutralCut(window, i))
+            return i;
+
+    // Nothing safe yet
+    return 0;
+}
+
+bool Codec::shouldStream(const std::string& path) {
+
+    // Missing files are reported by whichever path opens them
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    return !error && size > StreamThreshold;
+}
+
+Codec::Stats Codec::compressStream(const std::string& inputPath, const std::string& outputPath, const CompressionTable& table, unsigned threads) {
+
+    // Open both files
+    std::ifstream input(inputPath, std::ios::in | std::ios::binary);
+    if (!input.is_open())
+        throw std::runtime_error("Could not open text file for reading: " + inputPath);
+
+    ArchiveWriter output(outputPath, table, threads);
+
+    // The window holds carried-over bytes followed by freshly read ones; text is the normalized part being encoded
+    std::string window, text;
+    window.reserve(2 * ChunkSize);
+    text.reserve(2 * ChunkSize);
+
+    bool done = false;
+    while (!done) {
+
+        // Top up the window after whatever the previous round carried over
+        size_t carried = window.size();
+        window.resize(carried + ChunkSize);
+        input.read(window.data() + carried, ChunkSize);
+        size_t got = static_cast<size_t>(input.gcount());
+        window.resize(carried + got);
+        done = got < ChunkSize;
+
+        // Process up to a safe cut (everything, at the end of the input)
+        size_t cut = done ? window.size() : findSafeCut(window);
+        if (cut == 0 && !done)
+            continue;
+        text.assign(window, 0, cut);
+        window.erase(0, cut);
+
+        // Normalize this piece and hand it to the container, which encodes it a batch of blocks at a time
+        TextFile::normalize(text);
+        output.write(text);
+    }
+
+    // Encode the last block and write the index
+    ArchiveWriter::Stats written = output.finish();
+
+    Stats stats;
+    stats.textBytes = written.textBytes;
+    stats.payloadBits = written.payloadBits;
+    return stats;
+}
+
+Codec::Stats Codec::decompressStream(const std::string& inputPath, const std::string& outputPath, const CompressionTable& table, unsigned threads) {
+
+    // Open both files
+    std::ifstream input(inputPath, std::ios::in | std::ios::binary);
+    if (!input.is_open())
+        throw std::runtime_error("Could not open binary file for reading: " + inputPath);
+
+    std::ofstream output(outputPath, std::ios::out | std::ios::binary);
+    if (!output.is_open())
+        throw std::runtime_error("Could not open text file for writing: " + outputPath);
+
+    // A version 2 file is decoded a block at a time
+    uint8_t magic[8] = {};
+    input.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    input.clear();
+    if (Archive::isArchive(magic)) {
+        Archive::Index index = Archive::readIndex(input);
+        Archive::checkTable(index, table);
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        // Blocks are decoded a batch at a time: the batch's bytes are read in one go and every block is decoded
+        // straight into its slice of the text, which is then written in one go
+        Stats stats;
+        std::vector<uint8_t> data;
+        std::string text;
+        std::span<const Archive::Block> blocks(index.blocks);
+        size_t batch = threads * Archive::BatchBlocks;
+        for (size_t first = 0; first < blocks.size(); first += batch) {
+            std::span<const Archive::Block> group = blocks.subspan(first, std::min(batch, blocks.size() - first));
+
+            // Read from the first block's codes to the end of the last block's
+            uint64_t begin = group.front().payloadOffset;
+            uint64_t end = group.back().payloadOffset + (group.back().bitCount + 7) / 8;
+            data.resize(static_cast<size_t>(end - begin));
+            input.seekg(static_cast<std::streamoff>(begin), std::ios::beg);
+            input.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!input)
+                throw std::runtime_error("Could not read a block of: " + inputPath);
+
+            // Decode them all, then write their text
+            text.resize(static_cast<size_t>(group.back().sourceOffset + group.back().sourceBytes - group.front().sourceOffset));
+            Archive::decodeBlocks(table, group, data.data(), begin, text.data(), threads);
+            output.write(text.data(), static_cast<std::streamsize>(text.size()));
+            stats.textBytes += text.size();
+            for (const Archive::Block& block : group)
+                stats.payloadBits += block.bitCount;
+        }
+
+        // Make sure everything reached the disk
+        output.close();
+        if (output.fail())
+            throw std::runtime_error("Could not write text file: " + outputPath);
+        return stats;
+    }
+
+    // A legacy file: find out how many payload bits there really are (a file that was cut short only yields the bits it contains)
+    input.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(input.tellg());
+    input.seekg(0, std::ios::beg);
+    uint64_t bit_count = 0;
+    input.read(reinterpret_cast<char*>(&bit_count), sizeof(bit_count));
+    uint64_t payload_bits = file_size > sizeof(uint64_t) ? (file_size - sizeof(uint64_t)) * 8 : 0;
+    bit_count = std::min(bit_count, payload_bits);
+
+    // The block holds the unread tail of the previous block followed by freshly read bytes;
+    // block_start is the stream position of its first bit
+    std::vector<uint8_t> block;
+    block.reserve(ChunkSize + sizeof(uint64_t));
+    uint64_t block_start = 0;
+    unsigned skip_bits = 0;
+
+    // Decoded text is written out whenever this buffer fills up
+    std::vector<char> text(ChunkSize + table.decodeMargin());
+
+    Stats stats;
+    bool done = false;
+    while (!done) {
+
+        // Top up the block after whatever the previous round left unread
+        size_t carried = block.size();
+        block.resize(carried + ChunkSize);
+        input.read(reinterpret_cast<char*>(block.data() + carried), ChunkSize);
+        size_t got = static_cast<size_t>(input.gcount());
+        block.resize(carried + got);
+        done = got < ChunkSize;
+
+        // Only a code that is wholly inside the block can be decoded, unless this is the end of the stream
+        uint64_t block_bits = std::min<uint64_t>(uint64_t(block.size()) * 8, bit_count - block_start);
+        done = done || block_start + block_bits == bit_count;
+        uint64_t keep_bits = done ? 0 : CompressionTable::MaxCodeLength - 1;
+
+        // Decode what can be decoded, draining the output buffer each time it fills
+        BitReader reader(block.data(), block_bits);
+        reader.skip(skip_bits);
+        while (reader.remaining() > keep_bits) {
+            size_t length = table.decode(reader, text.data(), text.size(), keep_bits);
+            output.write(text.data(), static_cast<std::streamsize>(length));
+            stats.textBytes += length;
+        }
+
+        // Carry the unread bytes over (the first of them may be partly read)
+        size_t consumed = static_cast<size_t>(reader.position() / 8);
+        skip_bits = static_cast<unsigned>(reader.position() % 8);
+        block.erase(block.begin(), block.begin() + static_cast<std::ptrdiff_t>(consumed));
+        block_start += uint64_t(consumed) * 8;
+    }
+
+    // Make sure everything reached the disk
+    output.close();
+    if (output.fail())
+        throw std::runtime_error("Could not write text file: " + outputPath);
+
+    stats.payloadBits = bit_count;
+    return stats;
+}
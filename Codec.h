@@ -0,0 +1,54 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+
+/// @brief Static file-to-file compression pipelines (Don't create an object!)
+/// @note These work on fixed-size windows, so memory use does not grow with the input size.
+class Codec {
+    public:
+
+        /// @brief What a pipeline processed.
+        struct Stats {
+            uint64_t textBytes = 0;    // Bytes of (normalized) text
+            uint64_t payloadBits = 0;  // Bits of compressed payload
+        };
+
+        /// @brief The size of the windows read from the input (and of the decoder's output buffer).
+        static constexpr size_t ChunkSize = size_t(1) << 20;
+
+        /// @brief Inputs larger than this are better served by the streaming pipelines than by reading them whole.
+        static constexpr uint64_t StreamThreshold = uint64_t(64) << 20;
+
+        /// @brief Checks whether a file is large enough to go through the streaming pipelines.
+        /// @param path The file path.
+        /// @return True if the file exists and is larger than StreamThreshold.
+        static bool shouldStream(const std::string& path);
+
+        /// @brief Compresses a text file to a .bin file without holding either in memory.
+        /// @param inputPath The text file to compress.
+        /// @param outputPath The .bin file to write.
+        /// @param table The table to encode with (in Compress mode).
+        /// @param threads The number of threads to encode with (0 for one per core).
+        /// @return The number of text bytes encoded and compressed bits written.
+        /// @note Writes a version 2 file (see Archive), the same one ArchiveWriter writes for the whole normalized input
+        /// @note (except that in the LongestMatch and LazyMatch parses no entry spans two windows).
+        /// @note Throws if either file cannot be opened.
+        static Stats compressStream(const std::string& inputPath, const std::string& outputPath, const CompressionTable& table, unsigned threads = 0);
+
+        /// @brief Decompresses a .bin file to a text file without holding either in memory.
+        /// @param inputPath The .bin file to decompress.
+        /// @param outputPath The text file to write.
+        /// @param table The table to decode with (in Decompress mode).
+        /// @param threads The number of threads to decode version 2 files with (0 for one per core).
+        /// @return The number of compressed bits read and text bytes written.
+        /// @note Reads version 2 files a batch of blocks at a time (decoded in parallel) and legacy files a chunk at a time.
+        /// @note Throws if either file cannot be opened, the stream contains an invalid code, or a version 2 file
+        /// @note was written with a different table.
+        static Stats decompressStream(const std::string& inputPath, const std::string& outputPath, const CompressionTable& table, unsigned threads = 0);
+};
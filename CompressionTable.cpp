@@ -1,97 +1,388 @@
 #include "CompressionTable.h"
+#include "Simd.h"
 
-CompressionTable::CompressionTable(CSVFile& csv, Mode mode) : 
-    m_csv(&csv), m_mode(mode), m_map_binStr(nullptr), 
-    m_map_strBin(nullptr)
+// ---------------------- System Includes ----------------------
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+CompressionTable::CompressionTable(CSVFile& csv, Mode mode) :
+    m_csv(&csv), m_mode(mode)
 {
 
+    // Check if m_csv has been read
+    if(m_csv->getData() == nullptr)
+        m_csv->read();
+
+    // Check if reading was successful
+    if(m_csv->getData() == nullptr)
+        throw std::runtime_error("Failed to read CSV file in CompressionTable constructor!");
+
+    // Populate the flat entry table
+    for(const auto& row : *m_csv->getData()){
+
+        // Each row should have exactly 2 columns
+        if(row.size() != 2)
+            throw std::runtime_error("Invalid row in CSV file in CompressionTable constructor! (expected 2 columns, got " + std::to_string(row.size()) + ") \nRow data: "+[row](){std::string r="";for(auto& i:row)r+=i;return r;}());
+
+        // The first column is the string, the second column is the binary sequence (as a string of '0's and '1's)
+        const std::string& str = row[0];
+        const std::string& binStr = row[1];
+
+        // Make sure the code fits in a packed code
+        if(binStr.empty() || binStr.length() > MaxCodeLength)
+            throw std::runtime_error("Invalid binary string length in CSV file in CompressionTable constructor! (expected 1 to " + std::to_string(MaxCodeLength) + " bits, got " + std::to_string(binStr.length()) + ")");
+
+        // Convert the binary string to a packed code
+        Code code;
+        for(char c : binStr){
+            if(c == '0')
+                code.bits <<= 1;
+            else if(c == '1')
+                code.bits = (code.bits << 1) | 1u;
+            else
+                throw std::runtime_error("Invalid character in binary string in CSV file in CompressionTable constructor! (expected '0' or '1', got '" + std::string(1, c) + "')");
+        }
+        code.length = static_cast<uint8_t>(binStr.length());
+
+        // Make sure spaces and newlines are handled correctly
+        std::string insStr=str;
+        if(str == "<space>")insStr = " ";
+        if(str == "<newline>")insStr = "\n";
+
+        // An empty entry could never be matched or decoded meaningfully
+        if(insStr.empty())
+            throw std::runtime_error("Invalid empty string in CSV file in CompressionTable constructor!");
+
+        // Append the entry's text and record where it lives
+        m_symbolStore.push_back(Symbol{static_cast<uint32_t>(m_symbolTextStore.size()), static_cast<uint32_t>(insStr.length()), code});
+        m_symbolTextStore += insStr;
+
+        // Single characters also get a direct slot (the first definition wins, like the old map emplace)
+        if(insStr.length() == 1 && m_byteCodes[static_cast<uint8_t>(insStr[0])].length == 0)
+            m_byteCodes[static_cast<uint8_t>(insStr[0])] = code;
+    }
+
+    // Every lookup goes through the views
+    m_symbols = m_symbolStore;
+    m_symbolText = m_symbolTextStore;
+
+    // Point every unsupported byte at the '#' code (if the table has one) so lookups never need a fallback
+    Code pound = m_byteCodes[static_cast<uint8_t>('#')];
+    for(auto& code : m_byteCodes)
+        if(code.length == 0)
+            code = pound;
+
     // Check if we are in Compress or Decompress mode
     if(mode == Compress){
 
-        // Initialize the string to binary map
-        m_map_strBin = new std::unordered_map<std::string, std::vector<bool>>();
-
-        // Check if m_csv has been read
-        if(m_csv->getData() == nullptr)
-            m_csv->read();
-    
-        // Check if reading was successful
-        if(m_csv->getData() == nullptr)
-            throw std::runtime_error("Failed to read CSV file in CompressionTable constructor!");
-
-        // Populate the string to binary map
-        for(const auto& row : *m_csv->getData()){
-
-            // Each row should have exactly 2 columns
-            if(row.size() != 2)
-                throw std::runtime_error("Invalid row in CSV file in CompressionTable constructor! (expected 2 columns, got " + std::to_string(row.size()) + ") \nRow data: "+[row](){std::string r="";for(auto& i:row)r+=i;return r;}());
-
-            // The first column is the string, the second column is the binary sequence (as a string of '0's and '1's)
-            const std::string& str = row[0];
-            const std::string& binStr = row[1];
-
-            // Convert the binary string to a vector<bool>
-            std::vector<bool> bin;
-            for(char c : binStr){
-                if(c == '0')
-                    bin.push_back(false);
-                else if(c == '1')
-                    bin.push_back(true);
-                else
-                    throw std::runtime_error("Invalid character in binary string in CSV file in CompressionTable constructor! (expected '0' or '1', got '" + std::string(1, c) + "')");
+        // Build the multi-character entry matcher now that the table is complete
+        buildMatcher();
+    }
+
+    // We are in Decompress mode
+    else{
+
+        // Build the code trie and the lookup table
+        buildDecoder();
+    }
+}
+
+/// @brief Gets the built-in image, throwing if there is none.
+/// @return The built-in image.
+static const CompressionTable::Image& requireDefaultImage() {
+    const CompressionTable::Image* image = CompressionTable::defaultImage();
+    if(image == nullptr)
+        throw std::runtime_error("This program was built without a default compression table!");
+    return *image;
+}
+
+CompressionTable::CompressionTable(Mode mode) :
+    CompressionTable(requireDefaultImage(), mode)
+{}
+
+CompressionTable::CompressionTable(const Image& image, Mode mode, std::unique_ptr<MappedFile> backing) :
+    m_mode(mode), m_backing(std::move(backing))
+{
+
+    // The per-byte tables have a fixed size
+    if(image.byteCodes.size() != m_byteCodes.size() || (mode == Compress && image.matchClass.size() != m_matchClass.size()))
+        throw std::runtime_error("Invalid compression table image! (per-byte tables must have 256 entries)");
+
+    // Point every view straight at the given arrays
+    m_symbols = image.symbols;
+    m_symbolText = image.symbolText;
+    std::copy(image.byteCodes.begin(), image.byteCodes.end(), m_byteCodes.begin());
+
+    // Only the tables of the current mode are needed
+    if(mode == Compress){
+        std::copy(image.matchClass.begin(), image.matchClass.end(), m_matchClass.begin());
+        m_matchClassCount = image.matchClassCount;
+        m_matchNext = image.matchNext;
+        m_matchOut = image.matchOut;
+        m_matchShorter = image.matchShorter;
+        m_matchDepth = image.matchDepth;
+    }
+    else{
+        m_decodeTrie = image.decodeTrie;
+        m_decodeTable = image.decodeTable;
+        m_decodeMargin = image.decodeMargin;
+    }
+}
+
+CompressionTable::Image CompressionTable::image() const {
+    return Image{
+        m_symbols, m_symbolText, m_byteCodes,
+        m_decodeTrie, m_decodeTable, m_decodeMargin,
+        m_matchClass, m_matchClassCount, m_matchNext, m_matchOut, m_matchShorter, m_matchDepth
+    };
+}
+
+uint64_t CompressionTable::fingerprint() const {
+
+    // Hash each entry on its own (FNV-1a over its text, then its code) and add the hashes up
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < m_symbols.size(); ++i) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c : symbolText(i))
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+        uint64_t code = uint64_t(m_symbols[i].code.bits) << 8 | m_symbols[i].code.length;
+        for (int shift = 0; shift < 40; shift += 8)
+            hash = (hash ^ ((code >> shift) & 0xFF)) * 0x100000001B3ull;
+        sum += hash ^ (hash >> 31);
+    }
+
+    // Mix in the entry count
+    return (sum ^ m_symbols.size()) * 0x9E3779B97F4A7C15ull;
+}
+
+void CompressionTable::buildDecoder() {
+
+    // Start with just the root node
+    m_decodeTrieStore.assign(1, {0, 0});
+
+    // Insert every code into the trie
+    for(uint32_t i = 0; i < m_symbols.size(); ++i){
+        const Code& code = m_symbols[i].code;
+        int32_t node = 0;
+        for(int bit = code.length - 1; bit >= 0; --bit){
+            int32_t& child = m_decodeTrieStore[node][(code.bits >> bit) & 1u];
+
+            // A leaf on the last bit means an earlier entry has the same code (only one of them could ever be decoded)
+            if(child < 0 && bit == 0)
+                throw std::runtime_error("Invalid compression table " + source() + "! (duplicate code for '" +
+                                         std::string(symbolText(i)) + "' and '" + std::string(symbolText(static_cast<uint32_t>(~child))) + "')");
+
+            // A leaf on the way means an earlier code is a prefix of this one
+            if(child < 0)
+                throw std::runtime_error("Invalid compression table " + source() + "! (codes are not prefix-free)");
+
+            // Last bit: this is where the symbol lives, unless longer codes already continue from here
+            if(bit == 0){
+                if(child > 0)
+                    throw std::runtime_error("Invalid compression table " + source() + "! (codes are not prefix-free)");
+                child = ~static_cast<int32_t>(i);
+                break;
             }
 
-            // Insert into the map while making sure spaces and newlines are handled correctly
-            std::string insStr=str;
-            if(str == "<space>")insStr = " ";
-            if(str == "<newline>")insStr = "\n";
-            m_map_strBin->emplace(insStr, bin);
+            // Otherwise walk (or create) the inner node (child dangles once the trie grows, so read it first)
+            int32_t next = child;
+            if(next == 0){
+                next = child = static_cast<int32_t>(m_decodeTrieStore.size());
+                m_decodeTrieStore.push_back({0, 0});
+            }
+            node = next;
         }
+
+        // Slow-path symbols are copied whole, so the output margin must fit the longest one
+        m_decodeMargin = std::max<size_t>(m_decodeMargin, m_symbols[i].length);
     }
 
-    // We are in Decompress mode
-    else{
+    // Fill every lookup slot with as many whole symbols as its LookupBits bits contain
+    m_decodeTableStore.assign(size_t(1) << LookupBits, DecodeEntry{});
+    for(uint32_t window = 0; window < m_decodeTableStore.size(); ++window){
+        DecodeEntry& entry = m_decodeTableStore[window];
+        unsigned used = 0;
+
+        // Decode one symbol at a time, starting at the first unused bit
+        while(used < LookupBits){
+            int32_t node = 0;
+            unsigned bit = used;
+            while(bit < LookupBits && node >= 0){
+                node = m_decodeTrieStore[node][(window >> (LookupBits - 1 - bit)) & 1u];
+                ++bit;
+                if(node == 0) break;
+            }
 
-        // Initialize the binary to string map
-        m_map_binStr = new std::unordered_map<std::vector<bool>, std::string>();
-
-        // Check if m_csv has been read
-        if(m_csv->getData() == nullptr)
-            m_csv->read();
-        
-        // Check if reading was successful
-        if(m_csv->getData() == nullptr)
-            throw std::runtime_error("Failed to read CSV file in CompressionTable constructor!");
-
-        // Populate the binary to string map
-        for(const auto& row : *(m_csv->getData())){
-
-            // Each row should have exactly 2 columns
-            if(row.size() != 2)
-                throw std::runtime_error("Invalid row in CSV file in CompressionTable constructor! (expected 2 columns, got " + std::to_string(row.size()) + ")");
-
-            // The first column is the string, the second column is the binary sequence (as a string of '0's and '1's)
-            const std::string& str = row[0];
-            const std::string& binStr = row[1];
-
-            // Convert the binary string to a vector<bool>
-            std::vector<bool> bin;
-            for(char c : binStr){
-                if(c == '0')
-                    bin.push_back(false);
-                else if(c == '1')
-                    bin.push_back(true);
-                else
-                    throw std::runtime_error("Invalid character in binary string in CSV file in CompressionTable constructor! (expected '0' or '1', got '" + std::string(1, c) + "')");
+            // Stop at the first symbol that does not finish inside the window (or is invalid)
+            if(node >= 0)
+                break;
+
+            // Stop if its text would overflow the slot
+            std::string_view text = symbolText(~node);
+            if(entry.textLength + text.length() > sizeof(entry.text))
+                break;
+
+            // Append the symbol to the slot
+            std::memcpy(entry.text + entry.textLength, text.data(), text.length());
+            entry.textLength += static_cast<uint8_t>(text.length());
+            used = bit;
+        }
+        entry.bits = static_cast<uint8_t>(used);
+    }
+
+    // Every lookup goes through the views
+    m_decodeTrie = m_decodeTrieStore;
+    m_decodeTable = m_decodeTableStore;
+}
+
+void CompressionTable::buildMatcher() {
+
+    // Collect the multi-character entries (single characters are handled by direct lookups)
+    std::vector<uint32_t> entries;
+    for (uint32_t i = 0; i < m_symbols.size(); ++i)
+        if (m_symbols[i].length > 1)
+            entries.push_back(i);
+
+    // Give every byte that appears in an entry its own input class; every other byte shares class 0
+    m_matchClass.fill(0);
+    m_matchClassCount = 1;
+    for (uint32_t e : entries)
+        for (char c : symbolText(e))
+            if (m_matchClass[static_cast<uint8_t>(c)] == 0)
+                m_matchClass[static_cast<uint8_t>(c)] = m_matchClassCount++;
+
+    // Start with just the root state (-1 marks a missing trie edge)
+    const size_t classes = m_matchClassCount;
+    m_matchNextStore.assign(classes, -1);
+    m_matchOutStore.assign(1, -1);
+    m_matchDepthStore.assign(1, 0);
+
+    // Insert every entry into the trie
+    for (uint32_t e : entries) {
+        int32_t state = 0;
+        for (char c : symbolText(e)) {
+            size_t slot = state * classes + m_matchClass[static_cast<uint8_t>(c)];
+
+            // Create the child state if this edge does not exist yet
+            if (m_matchNextStore[slot] == -1) {
+                m_matchNextStore[slot] = static_cast<int32_t>(m_matchOutStore.size());
+                m_matchNextStore.resize(m_matchNextStore.size() + classes, -1);
+                m_matchOutStore.push_back(-1);
+                m_matchDepthStore.push_back(m_matchDepthStore[state] + 1);
             }
+            state = m_matchNextStore[slot];
+        }
+
+        // The entry ending at this state is the longest one it can report (the first definition wins)
+        if (m_matchOutStore[state] == -1)
+            m_matchOutStore[state] = static_cast<int32_t>(e);
+    }
+
+    // Breadth-first pass: compute failure links and turn the trie into a full transition table
+    std::vector<int32_t> fail(m_matchOutStore.size(), 0);
+    m_matchShorterStore.assign(m_matchOutStore.size(), 0);
+    std::vector<int32_t> queue;
+    queue.reserve(m_matchOutStore.size());
+
+    // Children of the root fail back to the root, missing edges loop on the root
+    for (size_t c = 0; c < classes; ++c) {
+        int32_t& child = m_matchNextStore[c];
+        if (child == -1) child = 0;
+        else queue.push_back(child);
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int32_t state = queue[head];
+
+        // If no entry ends exactly here, report the longest entry that is a suffix of this state
+        // (either way, shorter entries are found by following the failure chain)
+        if (m_matchOutStore[state] == -1) {
+            m_matchOutStore[state] = m_matchOutStore[fail[state]];
+            m_matchShorterStore[state] = m_matchShorterStore[fail[state]];
+        }
+        else m_matchShorterStore[state] = fail[state];
+
+        for (size_t c = 0; c < classes; ++c) {
+            int32_t& child = m_matchNextStore[state * classes + c];
+            int32_t fallback = m_matchNextStore[fail[state] * classes + c];
+
+            // Missing edge: borrow the transition of the failure state
+            if (child == -1) child = fallback;
+
+            // Real edge: its failure link is where the failure state goes on the same input
+            else {
+                fail[child] = fallback;
+                queue.push_back(child);
+            }
+        }
+    }
+
+    // Every lookup goes through the views
+    m_matchNext = m_matchNextStore;
+    m_matchOut = m_matchOutStore;
+    m_matchShorter = m_matchShorterStore;
+    m_matchDepth = m_matchDepthStore;
+}
+
+int32_t CompressionTable::findEntry(std::string_view str, size_t& pos) const {
+
+    // Walk the automaton once over str, keeping the leftmost (then longest) entry seen
+    const size_t classes = m_matchClassCount;
+    int32_t best = -1;
+    size_t bestPos = std::string::npos;
+    int32_t state = 0;
+    for (size_t i = 0; i < str.length(); ++i) {
+        state = m_matchNext[state * classes + m_matchClass[static_cast<uint8_t>(str[i])]];
+
+        // Nothing ends at this position
+        int32_t out = m_matchOut[state];
+        if (out == -1)
+            continue;
+
+        // A later end at the same (or an earlier) start is a longer match, so prefer it
+        size_t start = i + 1 - m_symbols[out].length;
+        if (start <= bestPos) {
+            best = out;
+            bestPos = start;
+        }
+    }
 
-            // Insert into the map while accounting for space and newline
-            std::string insStr=str;
-            if(str == "<space>")insStr = " ";
-            if(str == "<newline>")insStr = "\n";
-            m_map_binStr->emplace(bin, insStr);
+    pos = bestPos;
+    return best;
+}
+
+size_t CompressionTable::longestEntryAt(std::string_view str, size_t pos, int32_t& symbol) const {
+
+    // Follow trie edges only (a transition that does not go one level deeper is a failure shortcut)
+    const size_t classes = m_matchClassCount;
+    size_t length = 0;
+    int32_t state = 0;
+    for (size_t i = pos; i < str.length(); ++i) {
+        int32_t next = m_matchNext[state * classes + m_matchClass[static_cast<uint8_t>(str[i])]];
+        if (m_matchDepth[next] != m_matchDepth[state] + 1)
+            break;
+        state = next;
+
+        // Keep the entry that ends exactly here, if any
+        int32_t out = m_matchOut[state];
+        if (out != -1 && m_symbols[out].length == m_matchDepth[state]) {
+            symbol = out;
+            length = m_matchDepth[state];
         }
     }
+
+    return length;
+}
+
+CompressionTable::Code CompressionTable::charCode(char c) const {
+
+    // Unsupported characters were already pointed at '#' so an empty code means '#' is missing
+    Code code = m_byteCodes[static_cast<uint8_t>(c)];
+    if (code.length == 0)
+        throw std::runtime_error("'#' not found in the compression table " + source());
+
+    return code;
 }
 
 std::string CompressionTable::mapBinToStr(const std::vector<bool>& bin) const {
@@ -103,204 +394,307 @@ std::string CompressionTable::mapBinToStr(const std::vector<bool>& bin) const {
     if(bin.size() == 0)
         throw std::runtime_error("Invalid attempt to map empty binary vector!");
 
-    // Look up the binary sequence in the map
-    auto it = m_map_binStr->find(bin);
+    // Sequences longer than any code can never be in the table
+    if(bin.size() > MaxCodeLength)
+        return "#";
 
-    // If found, return the corresponding string
-    if(it != m_map_binStr->end())
-        return it->second;
+    // Pack the sequence and look it up
+    Code code;
+    for(bool bit : bin)
+        code.bits = (code.bits << 1) | static_cast<uint32_t>(bit);
+    code.length = static_cast<uint8_t>(bin.size());
 
-    // If not found return a "#"
-    else return "#";    
+    return std::string(mapBinToStr(code));
 }
 
-std::vector<bool> CompressionTable::mapStrToBin(const std::string& str) const {
+std::string_view CompressionTable::mapBinToStr(Code code) const {
 
-    // Make sure we are in Compress mode
-    if (m_mode == Decompress)
-        throw std::runtime_error("Invalid attempt to map string to binary in decompress mode!");
+    // Make sure we are in Decompress mode
+    if(m_mode == Compress)
+        throw std::runtime_error("Invalid attempt to map binary to string in compress mode!");
 
-    // Verify that an empty string was not passed
-    if (str.empty())
-        throw std::runtime_error("Invalid attempt to map empty string!");
+    // Walk the code through the trie
+    int32_t node = 0;
+    for(int bit = code.length - 1; bit >= 0; --bit){
+        node = m_decodeTrie[node][(code.bits >> bit) & 1u];
 
-    // Look up the string in the map (exact match)
-    auto it = m_map_strBin->find(str);
-    
-    // If found return the corresponding binary sequence
-    if (it != m_map_strBin->end())
-        return it->second;
+        // If not found return a "#"
+        if(node == 0)
+            return "#";
 
-    // If not found
-    if (str.length() > 1) {
+        // A symbol reached before the last bit means the code is longer than any in the table
+        if(node < 0 && bit != 0)
+            return "#";
+    }
 
-        // First attempt to find any multi-character table entry that is a substring of str_
-        for (const auto& pair : *m_map_strBin) {
+    // If the code ends exactly on a symbol, return the corresponding string
+    if(node < 0)
+        return symbolText(~node);
 
-            // Take the string from the Compression Table
-            const std::string& tableStr = pair.first;
+    // If not found return a "#"
+    else return "#";
+}
 
-            // Only consider multicharacter table entries here
-            if (tableStr.length() <= 1)
-                continue;
+uint32_t CompressionTable::decodeSlow(BitReader& in) const {
 
-            // Attempt to find this table entry in the query string
-            size_t pos = str.find(tableStr);
-            if (pos == std::string::npos)
-                continue; // try next table entry
+    // Walk down the trie one bit at a time until a symbol is reached
+    int32_t node = 0;
+    do {
 
-            // Found a matching substring so build a combined boolean vector consisting of binary(before) + binary(matched) + binary(after)
-            std::vector<bool> result;
+        // The stream ended in the middle of a code
+        if(in.remaining() == 0)
+            throw std::runtime_error("Invalid binary stream! (truncated code at bit " + std::to_string(in.position()) + ")");
 
-            // Process the part before the matched substring (if any)
-            if (pos > 0) {
+        node = m_decodeTrie[node][in.read(1)];
 
-                // Take a substring of the preceding characters
-                std::string before = str.substr(0, pos);
+        // No code starts with these bits
+        if(node == 0)
+            throw std::runtime_error("Invalid binary stream! (unknown code ending at bit " + std::to_string(in.position()) + ")");
 
-                // Iterate through the string char by char
-                for (char c : before) {
+    } while(node > 0);
 
-                    // Convert the character to a string
-                    std::string charStr(1, c);
+    return static_cast<uint32_t>(~node);
+}
 
-                    // Find the character in our map
-                    auto charIt = m_map_strBin->find(charStr);
+size_t CompressionTable::decode(BitReader& in, char* out, size_t capacity, uint64_t keepBits) const {
 
-                    if (charIt != m_map_strBin->end()) {
+    // Make sure we are in Decompress mode
+    if(m_mode == Compress)
+        throw std::runtime_error("Invalid attempt to map binary to string in compress mode!");
 
-                        // If the character is found, append it directly to our binary
-                        const std::vector<bool>& charBin = charIt->second;
-                        result.insert(result.end(), charBin.begin(), charBin.end());
-                    } else {
+    char* o = out;
+    char* stop = out + capacity - std::min(capacity, m_decodeMargin);
+    while(in.remaining() > keepBits && o < stop){
+
+        // Fast path: one lookup emits every symbol that fits in the next LookupBits bits
+        if(in.remaining() >= LookupBits){
+            const DecodeEntry& entry = m_decodeTable[in.peek(LookupBits)];
+            if(entry.bits != 0){
+                std::memcpy(o, entry.text, sizeof(entry.text));
+                o += entry.textLength;
+                in.skip(entry.bits);
+                continue;
+            }
+        }
 
-                        // Otherwise, append '#' binary
-                        auto hashIt = m_map_strBin->find("#");
+        // Slow path: long codes, long symbols and the tail of the stream
+        std::string_view text = symbolText(decodeSlow(in));
+        std::memcpy(o, text.data(), text.length());
+        o += text.length();
+    }
 
-                        if (hashIt != m_map_strBin->end()) {
-                            const std::vector<bool>& hashBin = hashIt->second;
-                            result.insert(result.end(), hashBin.begin(), hashBin.end());
-                        } else {
-                            throw std::runtime_error("'#' not found in the compression table " + m_csv->getPath());
-                        }
-                    }
-                }
-            }
+    return static_cast<size_t>(o - out);
+}
 
-            // Add the matched substring's binary representation (shorthand)
-            const std::vector<bool>& matchedBin = pair.second;
-            result.insert(result.end(), matchedBin.begin(), matchedBin.end());
+void CompressionTable::decode(BitReader& in, std::string& out) const {
 
-            // Process the part after the matched substring (if any)
-            size_t endPos = pos + tableStr.length();
-            if (endPos < str.length()) {
+    // Grow the string in large steps and decode straight into it
+    const size_t step = std::max<size_t>(size_t(1) << 16, m_decodeMargin * 2);
+    while(in.remaining() != 0){
+        size_t used = out.size();
+        out.resize(used + step);
+        out.resize(used + decode(in, out.data() + used, step));
+    }
+}
 
-                // Take a substring after the shorthand word
-                std::string after = str.substr(endPos);
+std::vector<bool> CompressionTable::mapStrToBin(const std::string& str) const {
 
-                // Iterate through the string char by char
-                for (char c : after) {
+    // Map to packed codes first
+    std::vector<Code> codes;
+    mapStrToBin(std::string_view(str), codes);
 
-                    // Convert the char to string
-                    std::string charStr(1, c);
+    // Unpack every code, most significant bit first
+    std::vector<bool> result;
+    for (const Code& code : codes)
+        for (int bit = code.length - 1; bit >= 0; --bit)
+            result.push_back((code.bits >> bit) & 1u);
 
-                    // Find the char in our map
-                    auto charIt = m_map_strBin->find(charStr);
+    return result;
+}
 
-                    if (charIt != m_map_strBin->end()) {
+template <typename Emit>
+void CompressionTable::forEachOptimalCode(std::string_view str, Emit&& emit) const {
+
+    // Shortest-path over the positions of str: best[j] is the cheapest way to encode its first j characters
+    struct Step {
+        uint32_t bits;    // Total bits so far
+        uint32_t codes;   // Total codes so far (the tie breaker)
+        int32_t symbol;   // The entry that ends here, or -1 for a single character
+    };
+    thread_local std::vector<Step> best;
+    constexpr uint32_t Unreachable = UINT32_MAX;
+    best.assign(str.length() + 1, Step{Unreachable, 0, -1});
+    best[0].bits = 0;
+
+    // Relaxes best[j] with a step that starts at i
+    auto relax = [&](size_t i, size_t j, uint8_t length, int32_t symbol) {
+        if (best[i].bits == Unreachable || length == 0)
+            return;
+        Step next{best[i].bits + length, best[i].codes + 1, symbol};
+        if (next.bits < best[j].bits || (next.bits == best[j].bits && next.codes < best[j].codes))
+            best[j] = next;
+    };
+
+    // Walk the automaton once; every entry ending at j is on the dictionary suffix chain of the state
+    const size_t classes = m_matchClassCount;
+    int32_t state = 0;
+    for (size_t j = 1; j <= str.length(); ++j) {
+        state = m_matchNext[state * classes + m_matchClass[static_cast<uint8_t>(str[j - 1])]];
+
+        // Longest entries first, so an equal-cost shorter one never replaces them
+        for (int32_t at = state; m_matchOut[at] != -1; at = m_matchShorter[at]) {
+            int32_t symbol = m_matchOut[at];
+            relax(j - m_symbols[symbol].length, j, m_symbols[symbol].code.length, symbol);
+        }
 
-                        // If the char was found, append it's binary
-                        const std::vector<bool>& charBin = charIt->second;
-                        result.insert(result.end(), charBin.begin(), charBin.end());
-                    } else {
+        // The character on its own
+        relax(j - 1, j, m_byteCodes[static_cast<uint8_t>(str[j - 1])].length, -1);
+    }
 
-                        // Otherwise, append '#' binary
-                        auto hashIt = m_map_strBin->find("#");
+    // Some character has no code at all (the table has no '#'); let charCode() report it
+    if (best[str.length()].bits == Unreachable)
+        for (char c : str)
+            charCode(c);
+
+    // Walk back from the end to recover the segmentation, then emit it in order
+    thread_local std::vector<Code> codes;
+    codes.clear();
+    for (size_t j = str.length(); j > 0;) {
+        int32_t symbol = best[j].symbol;
+        if (symbol == -1) {
+            codes.push_back(m_byteCodes[static_cast<uint8_t>(str[j - 1])]);
+            j -= 1;
+        }
+        else {
+            codes.push_back(m_symbols[symbol].code);
+            j -= m_symbols[symbol].length;
+        }
+    }
+    for (auto it = codes.rbegin(); it != codes.rend(); ++it)
+        emit(*it);
+}
 
-                        if (hashIt != m_map_strBin->end()) {
-                            const std::vector<bool>& hashBin = hashIt->second;
-                            result.insert(result.end(), hashBin.begin(), hashBin.end());
-                        } else {
-                            throw std::runtime_error("'#' not found in the compression table " + m_csv->getPath());
-                        }
-                    }
-                }
+template <typename Emit>
+void CompressionTable::forEachLongestMatchCode(std::string_view str, Emit&& emit) const {
+
+    // The longest entry at the current position (looked up ahead of time by the lazy check)
+    int32_t symbol = -1;
+    size_t length = longestEntryAt(str, 0, symbol);
+
+    size_t pos = 0;
+    while (pos < str.length()) {
+
+        // Lazy matching: if a longer entry starts at the next character, spell this one out and take that instead
+        int32_t nextSymbol = -1;
+        size_t nextLength = 0;
+        if (m_parse == LazyMatch && length != 0)
+            nextLength = longestEntryAt(str, pos + 1, nextSymbol);
+
+        // No entry (or a better one one character later): emit a single character
+        if (length == 0 || nextLength > length) {
+            emit(charCode(str[pos]));
+            pos += 1;
+            if (nextLength != 0) {
+                symbol = nextSymbol;
+                length = nextLength;
             }
-
-            return result; // A composite result using our table's shorthands (if present)
+            else length = longestEntryAt(str, pos, symbol);
+            continue;
         }
 
-        // No multi-character shorthand found so fall back to building the token char by char
-        std::vector<bool> result;
-        for (size_t i = 0; i < str.size(); ++i) {
+        // Take the entry
+        emit(m_symbols[symbol].code);
+        pos += length;
+        length = longestEntryAt(str, pos, symbol);
+    }
+}
 
-            // Take the character at the current index
-            char c = str[i];
+template <typename Emit>
+void CompressionTable::forEachCode(std::string_view str, Emit&& emit) const {
 
-            // Convert the character to a string
-            std::string charStr(1, c);
+    // Make sure we are in Compress mode
+    if (m_mode == Decompress)
+        throw std::runtime_error("Invalid attempt to map string to binary in decompress mode!");
 
-            // Find the character in our map
-            auto charIt = m_map_strBin->find(charStr);
+    // Verify that an empty string was not passed
+    if (str.empty())
+        throw std::runtime_error("Invalid attempt to map empty string!");
 
-            if (charIt != m_map_strBin->end()) {
+    // A single character is a direct lookup
+    if (str.length() == 1) {
+        emit(charCode(str[0]));
+        return;
+    }
 
-                // If found, append the binary representation
-                const std::vector<bool>& charBin = charIt->second;
-                result.insert(result.end(), charBin.begin(), charBin.end());
-            } else {
+    // Minimum-bit segmentation
+    if (m_parse == Optimal) {
+        forEachOptimalCode(str, emit);
+        return;
+    }
 
-                // Otherwise, fallback to '#'
-                auto poundIt = m_map_strBin->find("#");
+    // Longest match, across whatever the string contains
+    if (m_parse == LongestMatch || m_parse == LazyMatch) {
+        forEachLongestMatchCode(str, emit);
+        return;
+    }
 
-                // If # was found in our table
-                if (poundIt != m_map_strBin->end()) {
+    // Find the leftmost (then longest) multi-character entry in str; an exact match is simply the whole of str
+    size_t pos = 0;
+    int32_t match = findEntry(str, pos);
 
-                    // Append the '#' binary and continue
-                    result.insert(result.end(), poundIt->second.begin(), poundIt->second.end());
-                    continue;
-                }
-                else
-                    // If not found, throw an error
-                    throw std::runtime_error("'#' not found in the compression table "+m_csv->getPath());
+    // No multi-character shorthand found so fall back to building the token char by char
+    if (match == -1) {
+        for (char c : str)
+            emit(charCode(c));
+        return;
+    }
 
-                // Character not found and no fallback (Control should NEVER reach here)
-                throw std::runtime_error(std::string("Character '") + charStr + "' not found in the compression table " + m_csv->getPath());
-            }
-        }
+    // Build binary(before) + binary(matched) + binary(after)
+    for (char c : str.substr(0, pos))
+        emit(charCode(c));
 
-        return result;
-    }
+    emit(m_symbols[match].code);
+
+    for (char c : str.substr(pos + m_symbols[match].length))
+        emit(charCode(c));
+}
 
-    // If our word is of length 1
-    else if (str.length() == 1) {
+void CompressionTable::mapStrToBin(std::string_view str, std::vector<Code>& out) const {
 
-        // Convert the selected character to a string
-        std::string charStr(1, str[0]);
+    // Collect the codes into out
+    forEachCode(str, [&out](Code code){ out.push_back(code); });
+}
 
-        // Attempt to find the character in our table
-        auto charIt = m_map_strBin->find(charStr);
+void CompressionTable::encode(std::string_view str, BitWriter& out) const {
 
-        // Return it if found
-        if (charIt != m_map_strBin->end())
-            return charIt->second;
+    // Append the codes straight to the writer
+    forEachCode(str, [&out](Code code){ out.put(code.bits, code.length); });
+}
 
-        // Fallback to '#' for unknown single characters
-        auto poundIt = m_map_strBin->find("#");
+void CompressionTable::encodeText(std::string_view text, BitWriter& out) const {
 
-        // Return # if found
-        if (poundIt != m_map_strBin->end())
-            return poundIt->second;
-        else
-            // If not found, throw an error (should not happen)
-            throw std::runtime_error("'#' not found in the compression table "+m_csv->getPath());
-        
-        // Control should NEVER reach this statement
-        throw std::runtime_error(std::string("Character '") + charStr + "' not found in the compression table " + m_csv->getPath());
+    // The longest-match parses do not split words at all
+    if (m_parse == LongestMatch || m_parse == LazyMatch) {
+        if (!text.empty())
+            encode(text, out);
+        return;
     }
-    else {
 
-        // Something has gone VERY wrong if control reaches here!
-        throw std::runtime_error("Invalid string length in mapStrToBin!");
+    // Each word is encoded together with the space or newline that ends it
+    // (the delimiters are found a block at a time by the vector scanner)
+    uint32_t delimiters[Simd::ScanBlock];
+    size_t start = 0;
+    for (size_t block = 0; block < text.length(); block += Simd::ScanBlock) {
+        size_t length = std::min(Simd::ScanBlock, text.length() - block);
+        size_t count = Simd::findDelimiters(text.data() + block, length, delimiters);
+        for (size_t k = 0; k < count; ++k) {
+            size_t end = block + delimiters[k] + 1;
+            encode(text.substr(start, end - start), out);
+            start = end;
+        }
     }
+
+    // Handle the last word if it exists
+    if (start < text.length())
+        encode(text.substr(start), out);
 }
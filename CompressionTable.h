@@ -1,12 +1,17 @@
 #pragma once
 
 // ---------------------- System Includes ----------------------
-#include <unordered_map>
+#include <string_view>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <array>
+#include <span>
+#include <memory>
 
 // ---------------------- Project Includes ----------------------
 #include "File.h"
+#include "BitStream.h"
 
 /// @brief This class represents a compression table (aka dictionary) that will provide conversion
 /// @brief functions to and from shortened binary representations.
@@ -15,21 +20,118 @@ public:
     /// @brief This enum allows us to easily name what mode the program was run in.
     enum Mode {Compress, Decompress};
 
-    /// @brief This is the ONLY constructor that should be used!
-    /// @param csv The CSV file to read the table from.
+    /// @brief How the encoder splits text into table entries.
+    /// @note Greedy takes the leftmost (then longest) entry of each word and spells the rest out character by character.
+    /// @note Optimal picks the segmentation of each word with the fewest total bits.
+    /// @note LongestMatch ignores word boundaries and repeatedly takes the longest entry starting at the current position,
+    /// @note so entries containing spaces, newlines and punctuation (phrases) can be used.
+    /// @note LazyMatch is LongestMatch, except that it spells out one character first if a longer entry starts right after it.
+    enum Parse {Greedy, Optimal, LongestMatch, LazyMatch};
+
+    /// @brief A packed binary code: the low `length` bits of `bits`, most significant bit first.
+    /// @note A length of 0 means "no code".
+    struct Code {
+        uint32_t bits = 0;
+        uint8_t length = 0;
+    };
+
+    /// @brief The longest code (in bits) a table may assign.
+    static constexpr uint8_t MaxCodeLength = 32;
+
+    /// @brief The number of bits the decoder looks up at once.
+    static constexpr unsigned LookupBits = 12;
+
+    /// @brief A table entry: its text (a slice of the concatenated entry text) and its code.
+    struct Symbol {
+        uint32_t offset;
+        uint32_t length;
+        Code code;
+    };
+
+    /// @brief One slot of the decoder lookup table: the text of every symbol that fits entirely in LookupBits bits.
+    struct DecodeEntry {
+        char text[14];
+        uint8_t textLength;
+        uint8_t bits;   // Bits consumed (0 means no symbol fits and the slow path must be used)
+    };
+
+    /// @brief Read-only views of every table a CompressionTable looks things up in.
+    /// @note This is what the build-time generator dumps into DefaultTable.h, and what a table can be built from without copying.
+    /// @note The encoder fields are empty in an image taken in Decompress mode, and the decoder fields in Compress mode.
+    struct Image {
+        std::span<const Symbol> symbols;
+        std::string_view symbolText;
+        std::span<const Code> byteCodes;          // 256 entries
+        std::span<const std::array<int32_t, 2>> decodeTrie;
+        std::span<const DecodeEntry> decodeTable;
+        size_t decodeMargin;
+        std::span<const uint16_t> matchClass;     // 256 entries
+        size_t matchClassCount;
+        std::span<const int32_t> matchNext;
+        std::span<const int32_t> matchOut;
+        std::span<const int32_t> matchShorter;
+        std::span<const uint32_t> matchDepth;
+    };
+
+    /// @brief Builds a table from a CSV file.
+    /// @param csv The CSV file to read the table from. It must outlive the table.
     /// @param mode Whether the program is in compress or decompress mode.
     explicit CompressionTable(CSVFile& csv, Mode mode);
 
+    /// @brief Uses the table built into the program (see defaultImage()).
+    /// @param mode Whether the program is in compress or decompress mode.
+    /// @note Performs no file I/O and no heap allocation; the lookup tables are used where they are.
+    /// @note Throws if the program was built without a default table.
+    explicit CompressionTable(Mode mode);
+
+    /// @brief Uses lookup tables that already exist somewhere else (e.g. a mapped compiled table, see TableCache).
+    /// @param image Views of every lookup table; they are used in place, not copied.
+    /// @param mode Whether the program is in compress or decompress mode.
+    /// @param backing The mapping image points into, if any; the table keeps it alive.
+    CompressionTable(const Image& image, Mode mode, std::unique_ptr<MappedFile> backing = nullptr);
+
+    // The lookup views may point into the table's own storage
+    CompressionTable(const CompressionTable&) = delete;
+    CompressionTable& operator=(const CompressionTable&) = delete;
+
+    /// @brief Gets the table generated from csv/table.csv at build time.
+    /// @return The built-in image, or nullptr if the program was built without one.
+    /// @note Defined in DefaultTable.cpp.
+    static const Image* defaultImage();
+
+    /// @brief Gets views of this table's lookup tables.
+    /// @return The image; valid for the table's lifetime.
+    Image image() const;
+
+    /// @brief Identifies the table by what it maps (each entry's text and code).
+    /// @return A 64-bit hash, the same whether the table came from a CSV, a compiled file or the built-in image.
+    /// @note Order independent, so only a change to an entry or its code changes it.
+    uint64_t fingerprint() const;
+
     /// @brief Gets the current program mode.
     /// @return The current program mode.
     Mode getMode() const { return m_mode; }
 
+    /// @brief Gets how the encoder splits tokens.
+    /// @return The current parse.
+    Parse getParse() const { return m_parse; }
+
+    /// @brief Sets how the encoder splits tokens.
+    /// @param parse The parse to use from now on (Greedy by default).
+    void setParse(Parse parse) { m_parse = parse; }
+
     /// @brief Maps from binary sequences to strings.
     /// @brief This should only be used in Decompress mode.
     /// @param bin The binary sequence to map.
     /// @return The string mapped to the given binary sequence.
     std::string mapBinToStr(const std::vector<bool>& bin) const;
 
+    /// @brief Maps from a packed code to its string without allocating.
+    /// @brief This should only be used in Decompress mode.
+    /// @param code The packed code to map.
+    /// @return A view of the string mapped to the given code ("#" if there is none), valid for the table's lifetime.
+    std::string_view mapBinToStr(Code code) const;
+
     /// @brief Maps from strings to binary sequences.
     /// @brief This should only be used in Compress mode.
     /// @param str The string to map.
@@ -37,20 +139,182 @@ public:
     /// @note If str is a word, will attempt to find smaller words within it and return the built binary
     std::vector<bool> mapStrToBin(const std::string& str) const;
 
+    /// @brief Maps a single character to its packed code (the '#' code for unsupported characters).
+    /// @param c The character to map.
+    /// @return The packed code; its length is 0 only if the character is unsupported and the table has no '#'.
+    /// @note This is a single array load and is safe to call in either mode.
+    Code mapStrToBin(char c) const { return m_byteCodes[static_cast<uint8_t>(c)]; }
+
+    /// @brief Maps from strings to packed codes without allocating (beyond growing out).
+    /// @brief This should only be used in Compress mode.
+    /// @param str The string to map.
+    /// @param out The vector the codes are appended to. Reuse it between calls to avoid allocations.
+    /// @note Produces exactly the codes that mapStrToBin(const std::string&) concatenates.
+    void mapStrToBin(std::string_view str, std::vector<Code>& out) const;
+
+    /// @brief Encodes a string straight into a bit sink.
+    /// @brief This should only be used in Compress mode.
+    /// @param str The string to encode (a word, usually with its trailing space or newline).
+    /// @param out The writer the codes are appended to.
+    /// @note Appends exactly the bits mapStrToBin(const std::string&) returns, without allocating.
+    void encode(std::string_view str, BitWriter& out) const;
+
+    /// @brief Encodes a whole text, word by word, straight into a bit sink.
+    /// @brief This should only be used in Compress mode.
+    /// @param text The (normalized) text to encode.
+    /// @param out The writer the codes are appended to.
+    /// @note In the Greedy and Optimal parses every word is encoded together with the space or newline that ends it,
+    /// @note like the original compress loop; the LongestMatch and LazyMatch parses run over the text as a whole.
+    void encodeText(std::string_view text, BitWriter& out) const;
+
+    /// @brief Decodes symbols from a bit stream into a caller-supplied buffer.
+    /// @brief This should only be used in Decompress mode.
+    /// @param in The reader to decode from.
+    /// @param out The buffer decoded text is written to.
+    /// @param capacity The size of out. Must be larger than decodeMargin().
+    /// @param keepBits Decoding stops once no more than this many bits are left in `in` (0 decodes to the end).
+    /// @return The number of bytes written. Decoding stops once in is exhausted or out is within decodeMargin() of full.
+    /// @note Throws if the stream contains an invalid or truncated code.
+    /// @note Pass a keepBits of at least MaxCodeLength - 1 when in holds only part of a stream, so no code is cut off.
+    size_t decode(BitReader& in, char* out, size_t capacity, uint64_t keepBits = 0) const;
+
+    /// @brief Decodes every remaining symbol of a bit stream.
+    /// @brief This should only be used in Decompress mode.
+    /// @param in The reader to decode from.
+    /// @param out The string decoded text is appended to.
+    void decode(BitReader& in, std::string& out) const;
+
+    /// @brief Gets how much free room decode() needs in its output buffer to write one more lookup.
+    /// @return The margin in bytes.
+    size_t decodeMargin() const { return m_decodeMargin; }
+
 private:
+
+    /// @brief Builds the code trie and the decoder lookup table.
+    /// @note Called once from the constructor in Decompress mode.
+    /// @note Throws if two entries share a code or a code is a prefix of another (the text could not be decoded).
+    void buildDecoder();
+
+    /// @brief Decodes a single symbol by walking the code trie bit by bit.
+    /// @param in The reader to decode from.
+    /// @return The index of the decoded entry in m_symbols.
+    /// @note Used for codes longer than LookupBits, symbols too long for a lookup slot, and the tail of the stream.
+    uint32_t decodeSlow(BitReader& in) const;
+
+    /// @brief Builds the Aho-Corasick automaton over every multi-character entry of m_symbols.
+    /// @note Called once from the constructor in Compress mode.
+    void buildMatcher();
+
+    /// @brief Finds the leftmost (and among those the longest) multi-character entry contained in str.
+    /// @param str The string to search.
+    /// @param pos Receives the index where the entry starts in str.
+    /// @return The index of the matching entry in m_symbols, or -1 if str contains none.
+    /// @note Runs in a single pass over str regardless of how many entries the table has.
+    int32_t findEntry(std::string_view str, size_t& pos) const;
+
+    /// @brief Produces the minimum-bit codes for a string (forEachCode() in Optimal parse).
+    /// @param str The string to map (at least two characters).
+    /// @param emit Called with each code, in order.
+    /// @note Ties go to the segmentation with fewer codes, then to the longest entry ending at each position.
+    template <typename Emit>
+    void forEachOptimalCode(std::string_view str, Emit&& emit) const;
+
+    /// @brief Produces the longest-match codes for a string (forEachCode() in the LongestMatch and LazyMatch parses).
+    /// @param str The string to map.
+    /// @param emit Called with each code, in order.
+    template <typename Emit>
+    void forEachLongestMatchCode(std::string_view str, Emit&& emit) const;
+
+    /// @brief Finds the longest multi-character entry that starts at a position.
+    /// @param str The string to search.
+    /// @param pos The position the entry must start at.
+    /// @param symbol Receives the index of the entry in m_symbols (unchanged if there is none).
+    /// @return The length of the entry, or 0 if no entry starts at pos.
+    size_t longestEntryAt(std::string_view str, size_t pos, int32_t& symbol) const;
+
+    /// @brief Produces the codes for a string (the shared body of mapStrToBin and encode).
+    /// @param str The string to map.
+    /// @param emit Called with each code, in order.
+    template <typename Emit>
+    void forEachCode(std::string_view str, Emit&& emit) const;
+
+    /// @brief Gets the packed code of a single character, throwing if it has none.
+    /// @param c The character to map.
+    /// @return The character's code, or the '#' code for unsupported characters.
+    Code charCode(char c) const;
+
+    /// @brief Gets the text of a table entry.
+    /// @param symbol The index of the entry in m_symbols.
+    /// @return A view of the entry's text inside m_symbolText.
+    std::string_view symbolText(uint32_t symbol) const { return std::string_view(m_symbolText).substr(m_symbols[symbol].offset, m_symbols[symbol].length); }
+
+    /// @brief Gets a name for where the table came from, for error messages.
+    /// @return The CSV path, "(compiled)" or "(built-in)".
+    std::string source() const { return m_csv ? m_csv->getPath() : m_backing ? "(compiled)" : "(built-in)"; }
+
     /// @brief This member stores the CSV file that contains the compression table.
-    /// @note This file is always read-only.
-    CSVFile *m_csv;
+    /// @note This file is always read-only. It is nullptr for the built-in table.
+    CSVFile *m_csv = nullptr;
 
     /// @brief This member stores the current program mode.
     /// @note This member is always read-only.
     Mode m_mode;
 
-    /// @brief This member stores the mappings from binary sequences to strings.
+    /// @brief How the encoder splits tokens.
+    Parse m_parse = Greedy;
+
+    /// @brief Every table entry in file order; their texts are stored back to back in m_symbolText.
+    std::span<const Symbol> m_symbols;
+
+    /// @brief The concatenated text of every table entry.
+    std::string_view m_symbolText;
+
+    /// @brief The code of every single byte, with unsupported bytes already pointing at the '#' code.
+    std::array<Code, 256> m_byteCodes{};
+
+    /// @brief The code trie: each node's children for bit 0 and 1 (> 0 node index, < 0 ~symbol index, 0 none).
+    /// @note This member is only initialized in Decompress mode.
+    std::span<const std::array<int32_t, 2>> m_decodeTrie;
+
+    /// @brief The decoder lookup table, indexed by the next LookupBits bits of the stream.
     /// @note This member is only initialized in Decompress mode.
-    std::unordered_map<std::vector<bool>, std::string> *m_map_binStr; 
-    
-    /// @brief This member stores the mappings from strings to binary sequences.
+    std::span<const DecodeEntry> m_decodeTable;
+
+    /// @brief The free room decode() needs in its output buffer (a whole slot, or the longest entry).
+    size_t m_decodeMargin = sizeof(DecodeEntry::text);
+
+    /// @brief Maps each byte to its matcher input class (0 for bytes that appear in no entry).
+    std::array<uint16_t, 256> m_matchClass{};
+
+    /// @brief The number of matcher input classes (the row width of m_matchNext).
+    size_t m_matchClassCount = 1;
+
+    /// @brief The matcher's full transition table (state * m_matchClassCount + class -> state).
     /// @note This member is only initialized in Compress mode.
-    std::unordered_map<std::string, std::vector<bool>> *m_map_strBin;
-};
\ No newline at end of file
+    std::span<const int32_t> m_matchNext;
+
+    /// @brief For each matcher state, the longest entry ending there (index into m_symbols), or -1.
+    /// @note This member is only initialized in Compress mode.
+    std::span<const int32_t> m_matchOut;
+
+    /// @brief For each matcher state, its depth in the entry trie (the length of the text it stands for).
+    /// @note This member is only initialized in Compress mode.
+    std::span<const uint32_t> m_matchDepth;
+
+    /// @brief For each matcher state, the state whose m_matchOut is the next shorter entry ending there (the dictionary suffix link).
+    /// @note This member is only initialized in Compress mode.
+    std::span<const int32_t> m_matchShorter;
+
+    /// @brief The mapped compiled table the views point into (nullptr otherwise).
+    std::unique_ptr<MappedFile> m_backing;
+
+    // The storage behind the views above for a table read from CSV (all empty for the built-in table)
+    std::vector<Symbol> m_symbolStore;
+    std::string m_symbolTextStore;
+    std::vector<std::array<int32_t, 2>> m_decodeTrieStore;
+    std::vector<DecodeEntry> m_decodeTableStore;
+    std::vector<int32_t> m_matchNextStore;
+    std::vector<int32_t> m_matchOutStore;
+    std::vector<int32_t> m_matchShorterStore;
+    std::vector<uint32_t> m_matchDepthStore;
+};
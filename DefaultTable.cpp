@@ -0,0 +1,19 @@
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+
+// The Makefile generates DefaultTable.h from csv/table.csv (see tools/embed_table.cpp).
+// Builds that skip that step simply have no built-in table and read the CSV at run time.
+#if __has_include("DefaultTable.h")
+#include "DefaultTable.h"
+
+const CompressionTable::Image* CompressionTable::defaultImage() {
+    return &DefaultTable::image;
+}
+
+#else
+
+const CompressionTable::Image* CompressionTable::defaultImage() {
+    return nullptr;
+}
+
+#endif
@@ -1,10 +1,78 @@
 // ---------------------- Project Includes ----------------------
 #include "File.h"
+#include "Simd.h"
+#include "Archive.h"
 
 // ---------------------- System Includes ----------------------
 #include <fstream>
 #include <cstdint>
-#include <regex>
+#include <cstring>
+#include <algorithm>
+#include <array>
+
+// ---------------------- Platform Includes ----------------------
+#if defined(__unix__) || defined(__APPLE__)
+#define TEXTFLATTENER_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ****************** MappedFile Implementation ******************
+
+MappedFile::MappedFile(const std::string& path, Access access) {
+#ifdef TEXTFLATTENER_HAS_MMAP
+
+    // Open the file for reading
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open file for mapping: " + path);
+
+    // Find out how large it is
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file for mapping: " + path);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+
+    // Empty files cannot be mapped (and need not be)
+    if (m_size != 0) {
+        void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map file: " + path);
+        }
+
+        // A front-to-back scan lets the kernel read ahead aggressively; anything else keeps the default, since
+        // sequential read-ahead would fetch (and then drop) pages a lookup never touches
+        if (access == Sequential)
+            ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(mapping);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+#else
+
+    // No mmap here, so read the whole file into memory instead (there is no read-ahead to tune)
+    (void)access;
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Could not open file for mapping: " + path);
+    m_fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_fallback.data();
+    m_size = m_fallback.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef TEXTFLATTENER_HAS_MMAP
+    if (m_data != nullptr)
+        ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+}
 
 // ****************** TextFile Implementation ******************
 
@@ -52,8 +120,11 @@ void TextFile::write() {
     // If the file is open, write the stringstream's contents to the file
     if (file.is_open()) {
 
-        // Write the stringstream content to the file
-        if (m_data) file << m_data->str();
+        // Write the stringstream content to the file in one go (without copying it out first)
+        if (m_data) {
+            std::string_view content = m_data->view();
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
         
         // Observe the niceties
         file.close();
@@ -65,73 +136,189 @@ void TextFile::write() {
     }
 }
 
+void TextFile::readMapped() {
+
+    // Map the file for one front-to-back scan (throws if it cannot be opened)
+    m_map = std::make_unique<MappedFile>(getPath(), MappedFile::Sequential);
+
+    // The contents are the mapping itself until something has to change
+    m_normalized.clear();
+    m_view = m_map->view();
+}
+
 void TextFile::normalizePunctuation() {
-    if (!m_data) return;
 
-    std::string content = m_data->str();
+    // In mapped mode, only copy the mapping if it contains a byte normalization could change
+    if (m_map) {
+        bool clean = Simd::findSpecial(m_view.data(), m_view.size()) == m_view.size();
+        if (clean) return;
 
-    // UTF-8 encodings
-    const std::pair<std::string, std::string> replacements_utf8[] = {
-        { "\xE2\x80\x9C", "\"" }, // “ (left double quote)               -->  https://www.fileformat.info/info/unicode/char/201c/index.htm
-        { "\xE2\x80\x9D", "\"" }, // ” (right double quote)              -->  https://www.fileformat.info/info/unicode/char/201d/index.htm
-        { "\xE2\x80\x98", "'"  }, // ‘ (left single quote)               -->  https://www.fileformat.info/info/unicode/char/2018/index.htm
-        { "\xE2\x80\x99", "'"  }, // ’ (right single quote)              -->  https://www.fileformat.info/info/unicode/char/2019/index.htm
-        { "\xE2\x80\xB9", "'"  }, // ‹ (single low-9 quote)              -->  https://www.fileformat.info/info/unicode/char/2039/index.htm
-        { "\xE2\x80\xBA", "'"  }, // › (single high-9 quote)             -->  https://www.fileformat.info/info/unicode/char/203a/index.htm
-        { "\xE2\x80\x94", "-"  }, // — (em dash)                         -->  https://www.fileformat.info/info/unicode/char/2014/index.htm
-        { "\xE2\x80\xA6", "..."}, // ellipsis (…)                        -->  https://www.fileformat.info/info/unicode/char/2026/index.htm
-        { "\xC3\xA9",     "e"  }, // é (latin small letter e with acute) -->  https://www.fileformat.info/info/unicode/char/00e9/index.htm
-        { "\xC2\xA0",     " "  }, // non-breaking space ( )              -->  https://www.fileformat.info/info/unicode/char/00a0/index.htm
-        { "\xE2\x80\x8B", ""   }  // zero-width space                    -->  https://www.fileformat.info/info/unicode/char/200b/index.htm
-    };
-
-    // CP1252 encodings
-    const std::pair<std::string, std::string> replacements_cp1252[] = {
-
-        // - https://www.man7.org/linux//man-pages/man7/cp1252.7.html
-
-        { "\x93", "\"" }, // “
-        { "\x94", "\"" }, // ”
-        { "\x91", "'"  }, // ‘
-        { "\x92", "'"  }, // ’
-        { "\xE9", "e"  }, // é
-        { "\x97", "-"  }, // —
-        { "\x85", "..."}, // ellipsis
-        { "\xA0", " "  }  // non-breaking space
-    };
-
-    // Helper lambda for replacement
-    auto replaceAll = [](std::string &str, const std::string &from, const std::string &to) {
-        size_t pos = 0;
-        while ((pos = str.find(from, pos)) != std::string::npos) {
-            str.replace(pos, from.length(), to);
-            pos += to.length();
-        }
-    };
+        std::string content(m_view);
+        normalize(content);
+        m_normalized = std::move(content);
+        m_view = m_normalized;
+        return;
+    }
 
-    // Apply UTF-8 replacements
-    for (const auto &pair : replacements_utf8)
-        replaceAll(content, pair.first, pair.second);
+    if (!m_data) return;
 
-    // Apply CP1252 replacements
-    for (const auto &pair : replacements_cp1252)
-        replaceAll(content, pair.first, pair.second);
+    std::string content = m_data->str();
 
-    // Normalize line endings
-    content = std::regex_replace(content, std::regex("\r\n"), "\n");
-    content = std::regex_replace(content, std::regex("\r"), "\n");
+    // Apply the replacements
+    normalize(content);
 
     // Write back normalized data
     m_data->str(content);
     m_data->clear(); // reset stream state
 }
 
+/// @brief A normalization rule: a byte sequence and what it is replaced with.
+struct NormalizeRule {
+    std::string_view from;
+    std::string_view to;
+};
+
+// UTF-8 encodings (no two of these can overlap, so the order they are tried in does not matter)
+static constexpr NormalizeRule s_rulesUtf8[] = {
+    { "\xE2\x80\x9C", "\"" }, // “ (left double quote)               -->  https://www.fileformat.info/info/unicode/char/201c/index.htm
+    { "\xE2\x80\x9D", "\"" }, // ” (right double quote)              -->  https://www.fileformat.info/info/unicode/char/201d/index.htm
+    { "\xE2\x80\x98", "'"  }, // ‘ (left single quote)               -->  https://www.fileformat.info/info/unicode/char/2018/index.htm
+    { "\xE2\x80\x99", "'"  }, // ’ (right single quote)              -->  https://www.fileformat.info/info/unicode/char/2019/index.htm
+    { "\xE2\x80\xB9", "'"  }, // ‹ (single low-9 quote)              -->  https://www.fileformat.info/info/unicode/char/2039/index.htm
+    { "\xE2\x80\xBA", "'"  }, // › (single high-9 quote)             -->  https://www.fileformat.info/info/unicode/char/203a/index.htm
+    { "\xE2\x80\x94", "-"  }, // — (em dash)                         -->  https://www.fileformat.info/info/unicode/char/2014/index.htm
+    { "\xE2\x80\xA6", "..."}, // ellipsis (…)                        -->  https://www.fileformat.info/info/unicode/char/2026/index.htm
+    { "\xC3\xA9",     "e"  }, // é (latin small letter e with acute) -->  https://www.fileformat.info/info/unicode/char/00e9/index.htm
+    { "\xC2\xA0",     " "  }, // non-breaking space ( )              -->  https://www.fileformat.info/info/unicode/char/00a0/index.htm
+    { "\xE2\x80\x8B", ""   }  // zero-width space                    -->  https://www.fileformat.info/info/unicode/char/200b/index.htm
+};
+
+// CP1252 encodings
+static constexpr NormalizeRule s_rulesCp1252[] = {
+
+    // - https://www.man7.org/linux//man-pages/man7/cp1252.7.html
+
+    { "\x93", "\"" }, // “
+    { "\x94", "\"" }, // ”
+    { "\x91", "'"  }, // ‘
+    { "\x92", "'"  }, // ’
+    { "\xE9", "e"  }, // é
+    { "\x97", "-"  }, // —
+    { "\x85", "..."}, // ellipsis
+    { "\xA0", " "  }  // non-breaking space
+};
+
+/// @brief The zero-width space; it is dropped, so a '\r' and a '\n' with only these between them still form a line ending.
+static constexpr std::string_view s_zeroWidthSpace = "\xE2\x80\x8B";
+
+/// @brief What normalize() does when it meets a byte.
+enum NormalizeAction : uint8_t { Copy, Replace, CarriageReturn, Sequence };
+
+/// @brief The lead-byte dispatch table normalize() runs on.
+struct NormalizeTable {
+    std::array<uint8_t, 256> action{};               // A NormalizeAction for every byte
+    std::array<std::string_view, 256> replacement{}; // The replacement of every byte whose action is Replace
+};
+
+/// @brief Builds the dispatch table from the rules above.
+/// @return The table.
+static constexpr NormalizeTable makeNormalizeTable() {
+    NormalizeTable table;
+
+    // Bytes that start a UTF-8 rule have to look at what follows
+    for (const NormalizeRule& rule : s_rulesUtf8)
+        table.action[static_cast<uint8_t>(rule.from[0])] = Sequence;
+
+    // CP1252 bytes are replaced on their own (none of them starts a UTF-8 rule)
+    for (const NormalizeRule& rule : s_rulesCp1252) {
+        table.action[static_cast<uint8_t>(rule.from[0])] = Replace;
+        table.replacement[static_cast<uint8_t>(rule.from[0])] = rule.to;
+    }
+
+    // Line endings
+    table.action[static_cast<uint8_t>('\r')] = CarriageReturn;
+    return table;
+}
+
+/// @brief The dispatch table, built at compile time.
+static constexpr NormalizeTable s_normalizeTable = makeNormalizeTable();
+
+void TextFile::normalize(std::string& content) {
+
+    // Only the CP1252 ellipsis grows (1 byte to 3), so this is always enough room
+    const char* in = content.data();
+    const size_t size = content.size();
+    std::string normalized(size + 2 * static_cast<size_t>(std::count(content.begin(), content.end(), '\x85')), '\0');
+    char* out = normalized.data();
+
+    // One pass, dispatching on each byte
+    size_t i = 0;
+    while (i < size) {
+
+        // Copy plain ASCII runs in bulk
+        size_t run = Simd::findSpecial(in + i, size - i);
+        std::memcpy(out, in + i, run);
+        out += run;
+        i += run;
+        if (i == size)
+            break;
+
+        uint8_t c = static_cast<uint8_t>(in[i]);
+        switch (s_normalizeTable.action[c]) {
+
+            // Almost everything is copied as is
+            case Copy:
+                *out++ = in[i++];
+                break;
+
+            // CP1252 bytes
+            case Replace: {
+                std::string_view to = s_normalizeTable.replacement[c];
+                std::memcpy(out, to.data(), to.size());
+                out += to.size();
+                ++i;
+                break;
+            }
+
+            // "\r\n" becomes "\n" and any other '\r' becomes '\n'
+            case CarriageReturn: {
+                size_t next = i + 1;
+                while (std::string_view(in + next, size - next).starts_with(s_zeroWidthSpace))
+                    next += s_zeroWidthSpace.size();
+                if (next == size || in[next] != '\n')
+                    *out++ = '\n';
+                ++i;
+                break;
+            }
+
+            // The start of a UTF-8 rule (a lead byte that starts none of them is not a CP1252 byte either, so it is kept)
+            case Sequence: {
+                std::string_view rest(in + i, size - i);
+                const NormalizeRule* match = std::find_if(std::begin(s_rulesUtf8), std::end(s_rulesUtf8),
+                    [&](const NormalizeRule& rule){ return rest.starts_with(rule.from); });
+                if (match == std::end(s_rulesUtf8)) {
+                    *out++ = in[i++];
+                    break;
+                }
+                std::memcpy(out, match->to.data(), match->to.size());
+                out += match->to.size();
+                i += match->from.size();
+                break;
+            }
+        }
+    }
+
+    // Hand back the normalized text
+    normalized.resize(static_cast<size_t>(out - normalized.data()));
+    content = std::move(normalized);
+}
+
 // ****************** BinaryFile Implementation ******************
 
-BinaryFile::BinaryFile(std::string path, std::vector<bool>* data) : m_data(data) {
+BinaryFile::BinaryFile(std::string path, BitBuffer* data) : m_data(data) {
 
-    // If no data provided, create a new vector<bool>
-    if(!data) m_data = new std::vector<bool>();
+    // If no data provided, create a new BitBuffer
+    if(!data) m_data = new BitBuffer();
         
     // Set the file path
     setPath(path);
@@ -139,59 +326,77 @@ BinaryFile::BinaryFile(std::string path, std::vector<bool>* data) : m_data(data)
 
 BinaryFile::~BinaryFile() = default;
 
+/// @brief Reads the blocks of a version 2 file into one stream.
+/// @param file The open file.
+/// @param data Receives the blocks' bits, one after the other.
+static void readBlocks(std::istream& file, BitBuffer& data) {
+
+    // Find the blocks
+    Archive::Index index = Archive::readIndex(file);
+
+    // Copy each block's bits after the previous block's (blocks are padded to whole bytes, the stream is not)
+    data.clear();
+    data.reserve(index.textBytes * 8);
+    BitWriter writer(data);
+    std::vector<uint8_t> payload;
+    for (const Archive::Block& block : index.blocks) {
+        payload.resize(static_cast<size_t>((block.bitCount + 7) / 8));
+        file.seekg(static_cast<std::streamoff>(block.payloadOffset), std::ios::beg);
+        file.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file)
+            throw std::runtime_error("Could not read a block of the .bin file");
+        if (!Archive::checkBlock(block, payload.data()))
+            throw std::runtime_error("A block of the .bin file is damaged (checksum mismatch at text offset " + std::to_string(block.sourceOffset) + ")");
+
+        BitReader reader(payload.data(), block.bitCount);
+        while (reader.remaining() >= 32)
+            writer.put(reader.read(32), 32);
+        if (reader.remaining() != 0) {
+            unsigned rest = static_cast<unsigned>(reader.remaining());
+            writer.put(reader.read(rest), static_cast<uint8_t>(rest));
+        }
+    }
+    writer.flush();
+}
+
 void BinaryFile::read() {
 
     // Open the file for reading
     std::ifstream file;
     file.open(getPath(), std::ios::in | std::ios::binary);
 
-    // If the file is open, read its contents into the vector<bool>
+    // If the file is open, read its contents into the BitBuffer
     if (file.is_open()) {
 
+        // Find out how many payload bytes follow the header
+        file.seekg(0, std::ios::end);
+        uint64_t file_size = static_cast<uint64_t>(file.tellg());
+        file.seekg(0, std::ios::beg);
+
+        // A version 2 file: join its blocks into one stream
+        uint8_t magic[8] = {};
+        file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+        file.clear();
+        file.seekg(0, std::ios::beg);
+        if (Archive::isArchive(magic)) {
+            readBlocks(file, *m_data);
+            file.close();
+            return;
+        }
+
+        uint64_t payload_bits = file_size > sizeof(uint64_t) ? (file_size - sizeof(uint64_t)) * 8 : 0;
+
         // Read the bit count
-        uint64_t bit_count;
+        uint64_t bit_count = 0;
         file.read(reinterpret_cast<char*>(&bit_count), sizeof(bit_count));
 
-        // Clear existing data
-        m_data->clear();
-        
-        // Reserving space avoids excessive reallocations when reading many bytes.
-        m_data->reserve(bit_count);
-
-        // Read the file content byte by byte
-        char byte;
-        size_t bits_read = 0;
-        while (file.get(byte) && bits_read < bit_count) {
-
-            // Convert each byte to its 8 bits (MSB first) and append to m_data.
-            //
-            // Notes:
-            // - We cast `byte` to uint8_t to make sure that right-shifts are logical
-            //   and not implementation-defined for a signed `char`.
-            // - We append bits in big-endian order (most-significant bit first)
-            //   so that the first pushed bit corresponds to bit 7 of the byte.
-            uint8_t ubyte = static_cast<uint8_t>(byte);
-
-            // Determine how many bits to read from this byte
-            size_t bits_to_read = std::min(size_t(8), bit_count - bits_read);
-
-            // Extract bits one at a time from bit 7 down (MSB first, since most modern machines are little-endian)
-            for (size_t i = 0; i < bits_to_read; ++i) {
-
-                // Start from bit 7, go down
-                int bit_index = 7 - i;
-
-                // Shift the byte right by `bit_index` places so that the desired
-                // bit lands in position 0, then mask with 1 to isolate it.
-                // The expression yields 0 or 1 which is implicitly convertible
-                // to bool when pushed into std::vector<bool>.
-                uint8_t bit = (ubyte >> bit_index) & 0x1u;
-                m_data->push_back(static_cast<bool>(bit));
-            }
+        // Size the buffer for every bit the header promises (a file that was
+        // cut short only yields the bits it actually contains)
+        m_data->resize(std::min(bit_count, payload_bits));
 
-            // Increment bits_read
-            bits_read += bits_to_read;
-        }
+        // Read the whole payload in one block. The buffer's bytes are already in
+        // file order (MSB first), so no per-bit unpacking is needed.
+        file.read(reinterpret_cast<char*>(m_data->bytes()), static_cast<std::streamsize>(m_data->byteSize()));
 
         // Observe the niceties
         file.close();
@@ -209,7 +414,7 @@ void BinaryFile::write() {
     std::ofstream file;
     file.open(getPath(), std::ios::out | std::ios::binary);
 
-    // If the file is open, write the vector<bool>'s contents to the file
+    // If the file is open, write the BitBuffer's contents to the file
     if (file.is_open()) {
 
         // Write the bit count first (as a 64-bit value) so we know how many
@@ -217,43 +422,9 @@ void BinaryFile::write() {
         uint64_t bit_count = m_data->size();
         file.write(reinterpret_cast<const char*>(&bit_count), sizeof(bit_count));
 
-        // Pack bits from m_data into bytes and write them to the file.
-        // We treat bits in m_data as MSB-first within each byte: the bit at
-        // index `i` becomes bit 7 of the first output byte, index `i+1` becomes
-        // bit 6, and so on. When the remaining bits are fewer than 8, we left-
-        // align them so that they occupy the most-significant positions of the
-        // final output byte (this mirrors the MSB-first read logic).
-        for (size_t i = 0; i < m_data->size(); i += 8) {
-            // Use an unsigned 8-bit accumulator to avoid signed-shift UB.
-            uint8_t byte_acc = 0;
-
-            // How many bits remain in the final (possibly partial) chunk?
-            size_t remaining = m_data->size() - i;
-            size_t bits_this_round = remaining < 8 ? remaining : 8;
-
-            // Shift in each bit (MSB-first): shift accumulator left one and OR
-            // the next bit into the lowest position. After processing all bits
-            // of this chunk the bits will occupy the lowest `bits_this_round`
-            // positions of the accumulator, in the same order they appeared in
-            // m_data.
-            for (size_t j = 0; j < bits_this_round; ++j) {
-
-                // (*m_data)[i + j] yields a proxy/bool; cast to uint8_t for OR.
-                byte_acc = static_cast<uint8_t>((byte_acc << 1) |
-                                                static_cast<uint8_t>((*m_data)[i + j]));
-            }
-
-            // If this was a partial chunk (< 8 bits), shift the assembled
-            // bits left so they occupy the most-significant bits of the byte
-            // (bit 7 downwards). For a full chunk, (bits_this_round == 8)
-            // this shift is zero.
-            if (bits_this_round < 8) {
-                byte_acc <<= static_cast<uint8_t>(8 - bits_this_round);
-            }
-
-            // Write the packed byte to the file. Cast to char for file.put.
-            file.put(static_cast<char>(byte_acc));
-        }
+        // The buffer's bytes are already packed MSB first with the final partial
+        // byte left-aligned, so the payload goes out in one block.
+        file.write(reinterpret_cast<const char*>(m_data->bytes()), static_cast<std::streamsize>(m_data->byteSize()));
 
         // Observe the niceties
         file.close();
@@ -265,6 +436,31 @@ void BinaryFile::write() {
     }
 }
 
+void BinaryFile::readMapped(MappedFile::Access access) {
+
+    // Map the file (throws if it cannot be opened)
+    m_map = std::make_unique<MappedFile>(getPath(), access);
+
+    // A version 2 file is handed over whole; its index says where the blocks are
+    std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(m_map->data()), m_map->size());
+    m_archive = Archive::isArchive(bytes);
+    if (m_archive) {
+        m_payload = bytes;
+        m_bitCount = 0;
+        return;
+    }
+
+    // Read the bit count (a file too short for a header has no bits)
+    uint64_t bit_count = 0;
+    size_t header = std::min(m_map->size(), sizeof(bit_count));
+    if (header != 0)
+        std::memcpy(&bit_count, m_map->data(), header);
+
+    // The payload is everything after the header; a file that was cut short only yields the bits it contains
+    m_payload = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(m_map->data()) + header, m_map->size() - header);
+    m_bitCount = std::min<uint64_t>(bit_count, static_cast<uint64_t>(m_payload.size()) * 8);
+}
+
 // ****************** CSVFile Implementation ******************
 
 CSVFile::CSVFile(std::string path, std::vector<std::vector<std::string>>* data) : m_data(data) {
@@ -278,77 +474,110 @@ CSVFile::CSVFile(std::string path, std::vector<std::vector<std::string>>* data)
 
 CSVFile::~CSVFile() = default;
 
-void CSVFile::read() {
+void CSVFile::parse() {
 
     // Open the file for reading
     std::ifstream file;
-    file.open(getPath(), std::ios::in);
+    file.open(getPath(), std::ios::in | std::ios::binary);
 
-    // If the file is open, read its contents into the vector<vector<string>>
-    if (file.is_open()) {
+    // If the file could not be opened, throw an error
+    if (!file.is_open())
+        throw std::runtime_error("Could not open CSV file for reading: " + getPath());
 
-        // Clear existing data
-        m_data->clear();
-
-        // Read the file content line by line
-        std::string line;
-        while (std::getline(file, line)) {
-
-            // Split the line by commas into cells
-            std::vector<std::string> row;
-            std::string cell;
-            bool in_quotes = false, escaped = false;
-            char prev;
-            std::ostringstream field;
-            
-            // Iterate through the characters in this line
-            for (char c : line) {
-
-                // Check if the field is escaped
-                if (c == '\\')
-                    escaped = true;
-                
-                // Check if the escaped field is a quote
-                else if (c == '"') {
-
-                    // Toggle quote escapage
-                    if(!escaped)in_quotes = !in_quotes;
-
-                    // Escaped quote, treat as literal
-                    else field << c; 
-                }
-                
-                // Check for escaped delimiter
-                else if (c == ',' && !in_quotes) {
-                    row.push_back(field.str());
-                    field.str("");
-                }
-                
-                // Normal characters
-                else field << c;
-                
-                // Toggle escapage state
-                if(prev == '\\')escaped = false;
-
-                // Keep track of previous character
-                prev = c;
+    // Read the whole file in one go
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    m_buffer.assign(static_cast<size_t>(std::max<std::streamoff>(file_size, 0)), '\0');
+    file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.resize(static_cast<size_t>(file.gcount()));
+
+    // Observe the niceties
+    file.close();
+
+    m_cells.clear();
+    m_rowStarts.clear();
+
+    // Every line is a row (a final newline does not start another one)
+    char *data = m_buffer.data();
+    const size_t size = m_buffer.size();
+    size_t pos = 0;
+    while (pos < size) {
+        const char *newline = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        size_t end = newline ? static_cast<size_t>(newline - data) : size;
+        m_rowStarts.push_back(m_cells.size());
+
+        // A CRLF line ending's '\r' is not part of the last cell
+        size_t lineEnd = end;
+        if (lineEnd > pos && data[lineEnd - 1] == '\r')
+            --lineEnd;
+
+        // Split the line by commas into cells. Removing quotes and backslashes only ever shortens a cell,
+        // so each cell is rewritten in place (write never passes read)
+        bool in_quotes = false, escaped = false;
+        char prev = '\0';
+        size_t cell = pos, write = pos;
+        for (size_t read = pos; read < lineEnd; ++read) {
+
+            char c = data[read];
+
+            // Check if the field is escaped
+            if (c == '\\')
+                escaped = true;
+
+            // Check if the escaped field is a quote
+            else if (c == '"') {
+
+                // Toggle quote escapage
+                if(!escaped)in_quotes = !in_quotes;
+
+                // Escaped quote, treat as literal
+                else data[write++] = c;
+            }
+
+            // Unquoted delimiter: end the cell
+            else if (c == ',' && !in_quotes) {
+                m_cells.emplace_back(data + cell, write - cell);
+                cell = write;
             }
 
-            // Handle the last field
-            row.push_back(field.str());
+            // Normal characters
+            else data[write++] = c;
 
-            // Append the row
-            m_data->push_back(row);
+            // An escape only applies to the character right after the backslash
+            if(prev == '\\')escaped = false;
+
+            // Keep track of previous character
+            prev = c;
         }
 
-        // Observe the niceties
-        file.close();
+        // Handle the last field
+        m_cells.emplace_back(data + cell, write - cell);
+        pos = end + 1;
     }
-    
-    // If the file could not be opened, throw an error
-    else {
-        throw std::runtime_error("Could not open CSV file for reading: " + getPath());
+}
+
+void CSVFile::readViews() {
+    parse();
+}
+
+void CSVFile::read() {
+
+    // Split the file with the in-place parser
+    parse();
+
+    // Copy the cells into the vector<vector<string>>
+    m_data->clear();
+    m_data->reserve(getRowCount());
+    for (size_t i = 0; i < getRowCount(); ++i) {
+        std::span<const std::string_view> row = getRow(i);
+        m_data->emplace_back(row.begin(), row.end());
     }
+
+    // The views are not needed afterwards
+    m_cells.clear();
+    m_rowStarts.clear();
+    m_buffer.clear();
 }
 
 void CSVFile::write() {
@@ -1,9 +1,16 @@
 #pragma once
 
 // ---------------------- System Includes ----------------------
+#include <string_view>
+#include <cstdint>
 #include <string>
 #include <sstream>
 #include <vector>
+#include <memory>
+#include <span>
+
+// ---------------------- Project Includes ----------------------
+#include "BitStream.h"
 
 /// @brief This is an abstract base class for different types of files.
 class File {
@@ -22,6 +29,51 @@ private:
 
 };
 
+/// @brief This class represents a read-only memory mapping of a whole file.
+/// @note Falls back to reading the file into memory on platforms without mmap.
+class MappedFile {
+public:
+
+    /// @brief How the mapping will be read, so the kernel can tune its read-ahead.
+    enum Access {Normal, Sequential};
+
+    /// @brief Maps a file.
+    /// @param path The file path.
+    /// @param access Sequential only if the file is read front to back once; Normal for lookups and ranges.
+    /// @note Throws if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& path, Access access = Normal);
+
+    /// @brief Unmaps the file.
+    ~MappedFile();
+
+    // A mapping has a single owner
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @brief Gets the mapped bytes.
+    /// @return A pointer to the first byte (nullptr for an empty file).
+    const char* data() const { return m_data; }
+
+    /// @brief Gets the size of the file.
+    /// @return The number of mapped bytes.
+    size_t size() const { return m_size; }
+
+    /// @brief Gets the whole file as a string view.
+    /// @return A view of the mapped bytes, valid for the mapping's lifetime.
+    std::string_view view() const { return std::string_view(m_data, m_size); }
+
+private:
+
+    /// @brief The first mapped byte.
+    const char *m_data = nullptr;
+
+    /// @brief The number of mapped bytes.
+    size_t m_size = 0;
+
+    /// @brief The file contents on platforms without mmap.
+    std::string m_fallback;
+};
+
 /// @brief This class represents a text file.
 /// @note The data is stored in a stringstream for ease of manipulation.
 class TextFile : public File {
@@ -52,51 +104,116 @@ public:
     /// @note The caller is responsible for managing the memory of the provided stringstream.
     void setData(std::stringstream* data) { m_data = data; }
 
+    /// @brief Maps the file into memory instead of copying it into the stringstream.
+    /// @note The contents are then available through getView(); the stringstream is left untouched.
+    void readMapped();
+
+    /// @brief Checks whether the file was read with readMapped().
+    /// @return True if the contents live in getView() rather than the stringstream.
+    bool isMapped() const { return m_map != nullptr; }
+
+    /// @brief Gets the contents read with readMapped() (normalized, once normalizePunctuation() has run).
+    /// @return A read-only view, valid for the TextFile's lifetime.
+    std::string_view getView() const { return m_view; }
+
     /// @brief Normalizes punctuation in the text data by converting smart quotes and apostrophes to straight quotes and apostrophes. Also converts accented e to regular e.
     /// @note This modifies the content of the stringstream in place.
+    /// @note In mapped mode the mapping is only copied if something actually needs to change.
     void normalizePunctuation();
+
+    /// @brief Applies the normalizePunctuation() rules to a string in place.
+    /// @param content The text to normalize.
+    /// @note Normalizing two pieces separately gives the same result as normalizing them joined, as long as the first ends in an ASCII byte other than '\r'.
+    static void normalize(std::string& content);
 private:
 
     /// @brief The stringstream that holds the file's data.
     /// @note If this was provided in the constructor, the caller is responsible for managing its memory.
     std::stringstream *m_data;
+
+    /// @brief The mapping created by readMapped() (nullptr otherwise).
+    std::unique_ptr<MappedFile> m_map;
+
+    /// @brief The normalized copy of the mapping, if normalization had to change anything.
+    std::string m_normalized;
+
+    /// @brief The current contents in mapped mode (the mapping itself or m_normalized).
+    std::string_view m_view;
 };
 
 /// @brief This class represents a binary file.
-/// @note The data is stored in a vector<bool> for ease of manipulation.
+/// @note The data is stored in a word-packed BitBuffer whose bytes are the file's payload.
+/// @note File layout: a 64-bit bit count, then the bits packed MSB first into bytes.
 class BinaryFile : public File {
 public:
 
     /// @brief The constructor for BinaryFile.
     /// @param path The file path.
-    /// @param data The vector<bool> to use as data storage. If nullptr, a new vector<bool> will be created.
-    /// @note If a vector<bool> is provided, the caller is responsible for managing its memory.
-    BinaryFile(std::string path = "", std::vector<bool>* data = nullptr);
+    /// @param data The BitBuffer to use as data storage. If nullptr, a new BitBuffer will be created.
+    /// @note If a BitBuffer is provided, the caller is responsible for managing its memory.
+    BinaryFile(std::string path = "", BitBuffer* data = nullptr);
 
     /// @brief The destructor for BinaryFile.
     ~BinaryFile();
 
-    /// @brief Reads the file from disk into the vector<bool>.
+    /// @brief Reads the file from disk into the BitBuffer.
+    /// @note Legacy files are read with a single bulk read. The blocks of a version 2 file (see Archive) are
+    /// @note joined into one stream, which is what the legacy format would have held.
     void read() override;
 
-    /// @brief Writes the contents of the vector<bool> to disk.
+    /// @brief Writes the contents of the BitBuffer to disk.
+    /// @note The payload is written with a single bulk write.
     void write() override;
 
-    /// @brief Gets the vector<bool> data.
-    /// @note The caller is responsible for managing the memory of the returned vector<bool> if it was provided in the constructor.
-    /// @return The vector<bool> data.
-    std::vector<bool> *getData() { return m_data; }
+    /// @brief Gets the BitBuffer data.
+    /// @note The caller is responsible for managing the memory of the returned BitBuffer if it was provided in the constructor.
+    /// @return The BitBuffer data.
+    BitBuffer *getData() { return m_data; }
+
+    /// @brief Sets the BitBuffer data.
+    /// @param data The new BitBuffer to use as data storage.
+    /// @note The caller is responsible for managing the memory of the provided BitBuffer.
+    void setData(BitBuffer* data) { m_data = data; }
+
+    /// @brief Maps the file into memory instead of copying it into the BitBuffer.
+    /// @note The payload is then available through getPayload() and getBitCount(); the BitBuffer is left untouched.
+    /// @param access Sequential to decode or check the whole file; Normal to read only parts of it (e.g. a range).
+    /// @note For a version 2 file (isArchive()) the payload is the whole file, to be read with Archive::readIndex().
+    void readMapped(MappedFile::Access access = MappedFile::Sequential);
 
-    /// @brief Sets the vector<bool> data.
-    /// @param data The new vector<bool> to use as data storage.
-    /// @note The caller is responsible for managing the memory of the provided vector<bool>.
-    void setData(std::vector<bool>* data) { m_data = data; }
+    /// @brief Checks whether readMapped() found a version 2 (block-indexed) file.
+    /// @return True for a version 2 file, false for a legacy one.
+    bool isArchive() const { return m_archive; }
+
+    /// @brief Checks whether the file was read with readMapped().
+    /// @return True if the payload lives in getPayload() rather than the BitBuffer.
+    bool isMapped() const { return m_map != nullptr; }
+
+    /// @brief Gets the payload bytes read with readMapped().
+    /// @return A read-only span of the packed bytes (MSB first), valid for the BinaryFile's lifetime.
+    std::span<const uint8_t> getPayload() const { return m_payload; }
+
+    /// @brief Gets the number of valid payload bits read with readMapped().
+    /// @return The bit count from the header, capped at the bits the file actually contains (0 for a version 2 file).
+    uint64_t getBitCount() const { return m_bitCount; }
 
 private:
 
-    /// @brief The vector<bool> that holds the file's data.
+    /// @brief The mapping created by readMapped() (nullptr otherwise).
+    std::unique_ptr<MappedFile> m_map;
+
+    /// @brief The payload inside the mapping.
+    std::span<const uint8_t> m_payload;
+
+    /// @brief The number of valid bits in m_payload.
+    uint64_t m_bitCount = 0;
+
+    /// @brief Whether readMapped() found a version 2 file.
+    bool m_archive = false;
+
+    /// @brief The BitBuffer that holds the file's data.
     /// @note If this was provided in the constructor, the caller is responsible for managing its memory.
-    std::vector<bool> *m_data;
+    BitBuffer *m_data;
 };
 
 /// @brief This class represents a CSV file.
@@ -129,7 +246,37 @@ public:
     /// @note The caller is responsible for managing the memory of the provided vector<vector<string>>.
     void setData(std::vector<std::vector<std::string>> *data) { m_data = data; }
 
+    /// @brief Reads the file into one buffer and splits it in place, without copying any cell.
+    /// @note The rows are then available through getRowCount() and getRow(); the vector<vector<string>> is left untouched.
+    /// @note Quoting and escaping work exactly as in read().
+    void readViews();
+
+    /// @brief Gets the number of rows read with readViews().
+    /// @return The row count.
+    size_t getRowCount() const { return m_rowStarts.size(); }
+
+    /// @brief Gets a row read with readViews().
+    /// @param index The row index (less than getRowCount()).
+    /// @return The row's cells, viewing the CSVFile's buffer (valid until the next read).
+    std::span<const std::string_view> getRow(size_t index) const {
+        size_t end = index + 1 < m_rowStarts.size() ? m_rowStarts[index + 1] : m_cells.size();
+        return std::span<const std::string_view>(m_cells).subspan(m_rowStarts[index], end - m_rowStarts[index]);
+    }
+
 private:
+
+    /// @brief Loads the whole file into m_buffer and splits it into m_cells and m_rowStarts.
+    void parse();
+
+    /// @brief The file contents, with each cell unquoted and unescaped in place.
+    std::string m_buffer;
+
+    /// @brief Every cell of every row, in order, viewing m_buffer.
+    std::vector<std::string_view> m_cells;
+
+    /// @brief The index in m_cells of each row's first cell.
+    std::vector<size_t> m_rowStarts;
+
     /// @brief The vector<vector<string>> pointer that holds the file's data.
     /// @note If this was provided in the constructor, the caller is responsible for managing its memory.
     std::vector<std::vector<std::string>> *m_data;
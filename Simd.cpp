@@ -0,0 +1,227 @@
+// ---------------------- Project Includes ----------------------
+#include "Simd.h"
+
+// ---------------------- System Includes ----------------------
+#include <cstring>
+#include <array>
+#include <bit>
+
+// ---------------------- Platform Includes ----------------------
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TEXTFLATTENER_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Note: Function documentations listed in header file
+
+/// @brief One implementation of every kernel.
+struct SimdKernels {
+    size_t (*findSpecial)(const char*, size_t);
+    size_t (*findDelimiters)(const char*, size_t, uint32_t*);
+    uint32_t (*crc32c)(const uint8_t*, size_t, uint32_t);
+};
+
+// ****************** Scalar Kernels ******************
+
+/// @brief Scalar findSpecial(); also finishes the tails the vector kernels leave behind.
+static size_t findSpecialScalar(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        if ((static_cast<uint8_t>(data[i]) & 0x80) || data[i] == '\r')
+            return i;
+    return size;
+}
+
+/// @brief Scalar findDelimiters(); also finishes the tails the vector kernels leave behind.
+static size_t findDelimitersScalar(const char* data, size_t size, uint32_t* positions) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i)
+        if (data[i] == ' ' || data[i] == '\n')
+            positions[count++] = static_cast<uint32_t>(i);
+    return count;
+}
+
+/// @brief The slice-by-8 tables of CRC-32C: entry [k][b] is the checksum of byte b followed by k zero bytes.
+static constexpr std::array<std::array<uint32_t, 256>, 8> s_crcTables = []() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+
+    // One byte at a time with the reflected Castagnoli polynomial
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        uint32_t crc = byte;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+        tables[0][byte] = crc;
+    }
+
+    // Then each further zero byte
+    for (size_t k = 1; k < 8; ++k)
+        for (uint32_t byte = 0; byte < 256; ++byte)
+            tables[k][byte] = (tables[k - 1][byte] >> 8) ^ tables[0][tables[k - 1][byte] & 0xFF];
+    return tables;
+}();
+
+/// @brief Scalar crc32c(): eight bytes per step through the slice-by-8 tables (works on the inverted checksum).
+static uint32_t crc32cScalar(const uint8_t* data, size_t size, uint32_t crc) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+
+        // Fold the checksum into the next eight bytes, read least significant byte first
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big)
+            word = __builtin_bswap64(word);
+        word ^= crc;
+        crc = s_crcTables[7][word & 0xFF] ^ s_crcTables[6][(word >> 8) & 0xFF] ^
+              s_crcTables[5][(word >> 16) & 0xFF] ^ s_crcTables[4][(word >> 24) & 0xFF] ^
+              s_crcTables[3][(word >> 32) & 0xFF] ^ s_crcTables[2][(word >> 40) & 0xFF] ^
+              s_crcTables[1][(word >> 48) & 0xFF] ^ s_crcTables[0][word >> 56];
+    }
+
+    // The tail a byte at a time
+    for (; i < size; ++i)
+        crc = (crc >> 8) ^ s_crcTables[0][(crc ^ data[i]) & 0xFF];
+    return crc;
+}
+
+#ifdef TEXTFLATTENER_HAS_X86_SIMD
+
+// ****************** SSE4.2 Kernels ******************
+
+/// @brief SSE4.2 crc32c(): one crc32 instruction per eight bytes (works on the inverted checksum).
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(const uint8_t* data, size_t size, uint32_t crc) {
+    size_t i = 0;
+#if defined(__x86_64__)
+    uint64_t wide = crc;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<uint32_t>(wide);
+#endif
+    for (; i + 4 <= size; i += 4) {
+        uint32_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; i < size; ++i)
+        crc = _mm_crc32_u8(crc, data[i]);
+    return crc;
+}
+
+// ****************** SSE2 Kernels ******************
+
+/// @brief SSE2 findSpecial(): 16 bytes per step.
+__attribute__((target("sse2")))
+static size_t findSpecialSse2(const char* data, size_t size) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+
+        // The sign bits flag high bytes, the compare flags '\r'
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(block, _mm_cmpeq_epi8(block, cr))));
+        if (mask)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + findSpecialScalar(data + i, size - i);
+}
+
+/// @brief SSE2 findDelimiters(): 16 bytes per step.
+__attribute__((target("sse2")))
+static size_t findDelimitersSse2(const char* data, size_t size, uint32_t* positions) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, newline))));
+
+        // Hand back one position per set bit
+        while (mask) {
+            positions[count++] = static_cast<uint32_t>(i + static_cast<size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+
+    // Finish the tail, shifting its positions back into place
+    size_t tail = findDelimitersScalar(data + i, size - i, positions + count);
+    for (size_t k = count; k < count + tail; ++k)
+        positions[k] += static_cast<uint32_t>(i);
+    return count + tail;
+}
+
+// ****************** AVX2 Kernels ******************
+
+/// @brief AVX2 findSpecial(): 32 bytes per step.
+__attribute__((target("avx2")))
+static size_t findSpecialAvx2(const char* data, size_t size) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(block, _mm256_cmpeq_epi8(block, cr))));
+        if (mask)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + findSpecialSse2(data + i, size - i);
+}
+
+/// @brief AVX2 findDelimiters(): 32 bytes per step.
+__attribute__((target("avx2")))
+static size_t findDelimitersAvx2(const char* data, size_t size, uint32_t* positions) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, newline))));
+        while (mask) {
+            positions[count++] = static_cast<uint32_t>(i + static_cast<size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+
+    // Finish the tail, shifting its positions back into place
+    size_t tail = findDelimitersSse2(data + i, size - i, positions + count);
+    for (size_t k = count; k < count + tail; ++k)
+        positions[k] += static_cast<uint32_t>(i);
+    return count + tail;
+}
+
+#endif
+
+// ****************** Dispatch ******************
+
+/// @brief Picks the widest kernels the CPU supports.
+/// @return The chosen kernels (chosen once, on first use).
+static const SimdKernels& kernels() {
+    static const SimdKernels chosen = []() -> SimdKernels {
+#ifdef TEXTFLATTENER_HAS_X86_SIMD
+        __builtin_cpu_init();
+        auto crc32c = __builtin_cpu_supports("sse4.2") ? crc32cSse42 : crc32cScalar;
+        if (__builtin_cpu_supports("avx2"))
+            return { findSpecialAvx2, findDelimitersAvx2, crc32c };
+        if (__builtin_cpu_supports("sse2"))
+            return { findSpecialSse2, findDelimitersSse2, crc32c };
+        return { findSpecialScalar, findDelimitersScalar, crc32c };
+#else
+        return { findSpecialScalar, findDelimitersScalar, crc32cScalar };
+#endif
+    }();
+    return chosen;
+}
+
+size_t Simd::findSpecial(const char* data, size_t size) {
+    return kernels().findSpecial(data, size);
+}
+
+size_t Simd::findDelimiters(const char* data, size_t size, uint32_t* positions) {
+    return kernels().findDelimiters(data, size, positions);
+}
+
+uint32_t Simd::crc32c(const void* data, size_t size, uint32_t crc) {
+    return ~kernels().crc32c(static_cast<const uint8_t*>(data), size, ~crc);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <cstdint>
+#include <cstddef>
+
+/// @brief Static vectorized byte scanning kernels (Don't create an object!)
+/// @note The widest kernel the CPU supports (AVX2, SSE2 or plain C++) is picked once, at the first call.
+/// @note The checksum uses the SSE4.2 crc32 instruction when there is one, and slice-by-8 tables otherwise.
+class Simd {
+    public:
+
+        /// @brief Finds the first byte normalization could change (a byte with the high bit set, or '\r').
+        /// @param data The bytes to scan.
+        /// @param size The number of bytes.
+        /// @return The index of the first such byte, or size if the whole range is plain ASCII without '\r'.
+        static size_t findSpecial(const char* data, size_t size);
+
+        /// @brief Finds every word delimiter (' ' or '\n').
+        /// @param data The bytes to scan.
+        /// @param size The number of bytes.
+        /// @param positions Receives the index of each delimiter, in order. Must have room for size entries.
+        /// @return The number of delimiters found.
+        static size_t findDelimiters(const char* data, size_t size, uint32_t* positions);
+
+        /// @brief Computes the CRC-32C (Castagnoli) checksum of bytes.
+        /// @param data The bytes.
+        /// @param size The number of bytes.
+        /// @param crc The checksum of the bytes before these, to continue it (0 to start).
+        /// @return The checksum (0xE3069283 for "123456789").
+        static uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+        /// @brief A good range size for findDelimiters() (keeps the positions buffer on the stack).
+        static constexpr size_t ScanBlock = 4096;
+};
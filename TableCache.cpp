@@ -0,0 +1,240 @@
+// ---------------------- Project Includes ----------------------
+#include "TableCache.h"
+#include "Simd.h"
+
+// ---------------------- System Includes ----------------------
+#include <filesystem>
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <atomic>
+#include <span>
+
+// ---------------------- Platform Includes ----------------------
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Note: Function documentations listed in header file
+
+/// @brief Identifies a compiled table file.
+static constexpr char TftMagic[8] = {'T', 'F', 'T', 'A', 'B', 'L', 'E', '\0'};
+
+/// @brief Bumped whenever the layout (or anything the lookup tables depend on) changes.
+static constexpr uint32_t TftVersion = 2;
+
+/// @brief The sections of a compiled table, in file order.
+enum TftSection { Symbols, SymbolText, ByteCodes, DecodeTrie, DecodeTable, MatchClass, MatchNext, MatchOut, MatchShorter, MatchDepth, SectionCount };
+
+/// @brief Where a section lives in the file.
+struct TftSpan {
+    uint64_t offset;
+    uint64_t count;  // Number of elements
+};
+
+/// @brief The fixed-size start of a compiled table.
+struct TftHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;        // 0x01020304 as written by the machine that compiled it
+    uint32_t lookupBits;       // CompressionTable::LookupBits
+    uint32_t layout;           // sizeof of the element types, packed (catches ABI differences)
+    uint32_t checksum;         // CRC-32C of everything after the header
+    uint32_t reserved;
+    TableCache::Stamp stamp;
+    uint64_t decodeMargin;
+    uint64_t matchClassCount;
+    TftSpan sections[SectionCount];
+};
+
+/// @brief Packs the sizes of the element types a compiled table stores.
+/// @return The packed sizes.
+static constexpr uint32_t tftLayout() {
+    return static_cast<uint32_t>(sizeof(CompressionTable::Symbol)) |
+           static_cast<uint32_t>(sizeof(CompressionTable::Code)) << 8 |
+           static_cast<uint32_t>(sizeof(CompressionTable::DecodeEntry)) << 16 |
+           static_cast<uint32_t>(sizeof(std::array<int32_t, 2>)) << 24;
+}
+
+/// @brief Gets the raw bytes of an array.
+/// @param values The array.
+/// @return A view of its bytes.
+template <typename T>
+static std::span<const uint8_t> bytesOf(std::span<const T> values) {
+    return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(values.data()), values.size_bytes());
+}
+
+/// @brief Makes a temporary file name next to a file that no other writer (process or thread) uses at the same time.
+/// @param path The file the temporary one will be moved to.
+/// @return The temporary file name.
+static std::string temporaryPathFor(const std::string& path) {
+    static std::atomic<uint64_t> counter{0};
+#ifdef _WIN32
+    uint64_t process = static_cast<uint64_t>(::_getpid());
+#else
+    uint64_t process = static_cast<uint64_t>(::getpid());
+#endif
+    return path + "." + std::to_string(process) + "." + std::to_string(counter++) + ".tmp";
+}
+
+std::string TableCache::pathFor(const std::string& csvPath) {
+    return std::filesystem::path(csvPath).replace_extension(".tft").string();
+}
+
+TableCache::Stamp TableCache::stampOf(const std::string& csvPath) {
+    Stamp stamp;
+
+    // When and how large
+    stamp.mtime = static_cast<int64_t>(std::filesystem::last_write_time(csvPath).time_since_epoch().count());
+    stamp.size = static_cast<uint64_t>(std::filesystem::file_size(csvPath));
+
+    // What (FNV-1a over the contents)
+    MappedFile csv(csvPath, MappedFile::Sequential);
+    stamp.hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < csv.size(); ++i) {
+        stamp.hash ^= static_cast<uint8_t>(csv.data()[i]);
+        stamp.hash *= 0x100000001B3ull;
+    }
+
+    return stamp;
+}
+
+void TableCache::write(CSVFile& csv, const Stamp& stamp, const std::string& tftPath) {
+
+    // Build the table both ways; each mode only fills in its own lookup tables
+    CompressionTable encoder(csv, CompressionTable::Compress);
+    CompressionTable decoder(csv, CompressionTable::Decompress);
+    CompressionTable::Image enc = encoder.image();
+    CompressionTable::Image dec = decoder.image();
+
+    // The sections, in file order
+    const std::span<const uint8_t> sections[SectionCount] = {
+        bytesOf(enc.symbols), bytesOf(std::span<const char>(enc.symbolText)), bytesOf(enc.byteCodes),
+        bytesOf(dec.decodeTrie), bytesOf(dec.decodeTable), bytesOf(enc.matchClass),
+        bytesOf(enc.matchNext), bytesOf(enc.matchOut), bytesOf(enc.matchShorter), bytesOf(enc.matchDepth)
+    };
+    const uint64_t counts[SectionCount] = {
+        enc.symbols.size(), enc.symbolText.size(), enc.byteCodes.size(), dec.decodeTrie.size(), dec.decodeTable.size(),
+        enc.matchClass.size(), enc.matchNext.size(), enc.matchOut.size(), enc.matchShorter.size(), enc.matchDepth.size()
+    };
+
+    // Fill in the header, laying the sections out 8-byte aligned after it
+    TftHeader header{};
+    std::memcpy(header.magic, TftMagic, sizeof(TftMagic));
+    header.version = TftVersion;
+    header.byteOrder = 0x01020304u;
+    header.lookupBits = CompressionTable::LookupBits;
+    header.layout = tftLayout();
+    header.stamp = stamp;
+    header.decodeMargin = dec.decodeMargin;
+    header.matchClassCount = enc.matchClassCount;
+    uint64_t offset = sizeof(TftHeader);
+    for (int s = 0; s < SectionCount; ++s) {
+        offset = (offset + 7) & ~uint64_t(7);
+        header.sections[s] = TftSpan{offset, counts[s]};
+        offset += sections[s].size();
+    }
+
+    // Assemble the file in memory, then write it under a temporary name and move it into place,
+    // so a process loading the table never sees a half-written file
+    std::string image(static_cast<size_t>(offset), '\0');
+    for (int s = 0; s < SectionCount; ++s)
+        if (!sections[s].empty())
+            std::memcpy(image.data() + header.sections[s].offset, sections[s].data(), sections[s].size());
+
+    // The checksum lets a load tell a damaged file from a valid one
+    header.checksum = Simd::crc32c(image.data() + sizeof(header), image.size() - sizeof(header));
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    // Each writer has its own temporary file, so two processes compiling the same table cannot mix their output
+    std::string temporary = temporaryPathFor(tftPath);
+    std::ofstream file(temporary, std::ios::out | std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Could not open compiled table for writing: " + temporary);
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    file.close();
+    if (file.fail()) {
+        std::error_code error;
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Could not write compiled table: " + temporary);
+    }
+
+    // Moving it into place replaces any older version in one step
+    std::error_code error;
+    std::filesystem::rename(temporary, tftPath, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Could not move compiled table into place: " + tftPath);
+    }
+}
+
+/// @brief Gets a typed view of a section, if it lies wholly inside the mapping.
+/// @param map The mapping.
+/// @param section Where the section is.
+/// @param out Receives the view.
+/// @return False if the section is misaligned or out of bounds.
+template <typename T>
+static bool sectionView(const MappedFile& map, const TftSpan& section, std::span<const T>& out) {
+    if (section.offset % alignof(T) != 0 || section.offset > map.size() || section.count > (map.size() - section.offset) / sizeof(T))
+        return false;
+    out = std::span<const T>(reinterpret_cast<const T*>(map.data() + section.offset), static_cast<size_t>(section.count));
+    return true;
+}
+
+std::unique_ptr<MappedFile> TableCache::load(const std::string& tftPath, const Stamp& stamp, CompressionTable::Image& image) {
+
+    // A missing (or unreadable) compiled table is simply not used
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(tftPath, error))
+        return nullptr;
+    std::unique_ptr<MappedFile> map;
+    try {
+        map = std::make_unique<MappedFile>(tftPath, MappedFile::Normal);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+
+    // Check that it is a compiled table this build can use, made from this exact CSV
+    if (map->size() < sizeof(TftHeader))
+        return nullptr;
+    TftHeader header;
+    std::memcpy(&header, map->data(), sizeof(header));
+    if (std::memcmp(header.magic, TftMagic, sizeof(TftMagic)) != 0 || header.version != TftVersion ||
+        header.byteOrder != 0x01020304u || header.lookupBits != CompressionTable::LookupBits || header.layout != tftLayout())
+        return nullptr;
+    if (header.stamp.mtime != stamp.mtime || header.stamp.size != stamp.size || header.stamp.hash != stamp.hash)
+        return nullptr;
+
+    // And that it is intact: the sections hold trie and automaton indices that are used without bounds checks
+    if (Simd::crc32c(map->data() + sizeof(header), map->size() - sizeof(header)) != header.checksum)
+        return nullptr;
+
+    // Point the image at the sections
+    std::span<const char> symbolText;
+    std::span<const CompressionTable::Code> byteCodes;
+    std::span<const uint16_t> matchClass;
+    bool valid =
+        sectionView(*map, header.sections[Symbols], image.symbols) &&
+        sectionView(*map, header.sections[SymbolText], symbolText) &&
+        sectionView(*map, header.sections[ByteCodes], byteCodes) && byteCodes.size() == 256 &&
+        sectionView(*map, header.sections[DecodeTrie], image.decodeTrie) && !image.decodeTrie.empty() &&
+        sectionView(*map, header.sections[DecodeTable], image.decodeTable) && image.decodeTable.size() == (size_t(1) << CompressionTable::LookupBits) &&
+        sectionView(*map, header.sections[MatchClass], matchClass) && matchClass.size() == 256 &&
+        sectionView(*map, header.sections[MatchNext], image.matchNext) &&
+        sectionView(*map, header.sections[MatchOut], image.matchOut) &&
+        sectionView(*map, header.sections[MatchShorter], image.matchShorter) &&
+        sectionView(*map, header.sections[MatchDepth], image.matchDepth) &&
+        image.matchNext.size() == image.matchOut.size() * header.matchClassCount &&
+        image.matchShorter.size() == image.matchOut.size() && image.matchDepth.size() == image.matchOut.size();
+    if (!valid)
+        return nullptr;
+
+    image.symbolText = std::string_view(symbolText.data(), symbolText.size());
+    image.byteCodes = byteCodes;
+    image.matchClass = matchClass;
+    image.decodeMargin = static_cast<size_t>(header.decodeMargin);
+    image.matchClassCount = static_cast<size_t>(header.matchClassCount);
+    return map;
+}
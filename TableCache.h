@@ -0,0 +1,53 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+#include "File.h"
+
+/// @brief Static helpers for compiled (.tft) compression tables (Don't create an object!)
+/// @note A compiled table holds every lookup table of both modes as flat arrays, so it is used straight from
+/// @note its mapping: processes that load the same file share its pages instead of each parsing the CSV.
+/// @note File layout: a fixed header (magic, version, layout checks, a CRC-32C of the rest, the CSV stamp, section
+/// @note offsets and counts), then each section 8-byte aligned. Multi-byte values are in native byte order.
+class TableCache {
+    public:
+
+        /// @brief Identifies the exact CSV a compiled table was made from.
+        struct Stamp {
+            int64_t mtime = 0;  // Last write time (filesystem clock ticks)
+            uint64_t size = 0;  // Size in bytes
+            uint64_t hash = 0;  // FNV-1a hash of the contents
+        };
+
+        /// @brief Gets where the compiled version of a CSV table lives.
+        /// @param csvPath The CSV table path.
+        /// @return The same path with a .tft extension.
+        static std::string pathFor(const std::string& csvPath);
+
+        /// @brief Stamps a CSV table as it is on disk now.
+        /// @param csvPath The CSV table path.
+        /// @return The stamp.
+        /// @note Throws if the file cannot be read.
+        static Stamp stampOf(const std::string& csvPath);
+
+        /// @brief Compiles a CSV table.
+        /// @param csv The CSV table (read if it has not been yet).
+        /// @param stamp The stamp of the CSV, stored so later loads can tell if it changed.
+        /// @param tftPath The compiled table to write.
+        /// @note Throws if the table is invalid or the file cannot be written.
+        /// @note The file is written under a temporary name unique to the writer, then renamed into place.
+        static void write(CSVFile& csv, const Stamp& stamp, const std::string& tftPath);
+
+        /// @brief Maps a compiled table.
+        /// @param tftPath The compiled table.
+        /// @param stamp The stamp the CSV has now; the compiled table is only used if it was made from exactly this.
+        /// @param image Receives views of the lookup tables inside the mapping.
+        /// @return The mapping (hand it to the CompressionTable built on image), or nullptr if the file is missing,
+        /// @return stale, damaged (its checksum does not match) or not a valid compiled table.
+        static std::unique_ptr<MappedFile> load(const std::string& tftPath, const Stamp& stamp, CompressionTable::Image& image);
+};
@@ -0,0 +1,529 @@
+// ---------------------- Project Includes ----------------------
+#include "TableGenerator.h"
+#include "WordCounter.h"
+
+// ---------------------- System Includes ----------------------
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <cmath>
+
+// Note: Function documentations listed in header file
+
+/// @brief Checks whether a text can be stored as a multi-character table entry.
+/// @param text The entry text.
+/// @return False for texts the CSV format cannot carry (a newline ends the row, the reader drops every backslash) or
+/// @return that read back as something else (the <space> and <newline> names).
+static bool isStorable(std::string_view text) {
+    return !text.empty() && text.find_first_of("\\\n") == std::string_view::npos && text != "<space>" && text != "<newline>";
+}
+
+/// @brief Checks whether a character always gets an entry, even if the frequency data never mentions it.
+/// @param c The character.
+/// @return True for '#' (the stand-in for unsupported bytes), tabs, newlines and printable ASCII (e.g. the straight
+/// @return quotes normalization produces), so a generated table still covers any plain text.
+static bool isBaseChar(int c) {
+    return c == '\t' || c == '\n' || (c >= ' ' && c <= '~' && c != '\\');
+}
+
+/// @brief Writes an entry text as a CSV cell that CSVFile reads back unchanged.
+/// @param text The entry text.
+/// @return The cell.
+static std::string toCell(const std::string& text) {
+
+    // Spaces and newlines go by name
+    if (text == " ")
+        return "<space>";
+    if (text == "\n")
+        return "<newline>";
+
+    // Commas and quotes need quoting (quotes inside are escaped)
+    if (text.find_first_of(",\"") == std::string::npos)
+        return text;
+    std::string cell = "\"";
+    for (char c : text) {
+        if (c == '"')
+            cell += '\\';
+        cell += c;
+    }
+    return cell + "\"";
+}
+
+/// @brief Counts how often the encoder uses each entry of a table on a text.
+/// @param text The text.
+/// @param entries The table entries.
+/// @param parse How the encoder splits text.
+/// @return The number of codes emitted for each entry.
+static std::vector<uint64_t> countUses(std::string_view text, const std::vector<TableGenerator::Entry>& entries, CompressionTable::Parse parse) {
+
+    // A provisional table whose codes are the entry indices, all the same length, so every emitted code says which entry was used
+    unsigned indexBits = 1;
+    while ((uint64_t(1) << indexBits) < entries.size())
+        ++indexBits;
+    std::vector<std::vector<std::string>> rows;
+    for (size_t index = 0; index < entries.size(); ++index) {
+        std::string bits;
+        for (unsigned bit = indexBits; bit-- > 0;)
+            bits += ((index >> bit) & 1) ? '1' : '0';
+        rows.push_back({entries[index].text == " " ? "<space>" : entries[index].text == "\n" ? "<newline>" : entries[index].text, bits});
+    }
+    CSVFile csv("", &rows);
+    CompressionTable table(csv, CompressionTable::Compress);
+    table.setParse(parse);
+
+    // Encode the text as encodeText() splits it: word by word (each with the delimiter that ends it), or, for the
+    // longest-match parses, in long runs of words
+    bool wordWise = parse == CompressionTable::Greedy || parse == CompressionTable::Optimal;
+    std::vector<uint64_t> uses(entries.size(), 0);
+    std::vector<CompressionTable::Code> codes;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of(" \n", wordWise ? start : std::min(start + (size_t(1) << 16), text.size() - 1));
+        end = end == std::string_view::npos ? text.size() : end + 1;
+        codes.clear();
+        table.mapStrToBin(text.substr(start, end - start), codes);
+        for (const auto& code : codes)
+            ++uses[code.bits];
+        start = end;
+    }
+    return uses;
+}
+
+std::vector<TableGenerator::Entry> TableGenerator::weighText(std::string_view text, size_t words) {
+
+    // Count every byte and every token (tokens end at a space or newline, like the encoder's words)
+    uint64_t byteCounts[256] = {};
+    WordCounter tokens;
+    size_t start = 0;
+    for (size_t pos = 0; pos <= text.size(); ++pos) {
+        if (pos < text.size()) {
+            ++byteCounts[static_cast<unsigned char>(text[pos])];
+            if (text[pos] != ' ' && text[pos] != '\n')
+                continue;
+        }
+        if (pos - start >= 2)
+            tokens.add(text.substr(start, pos - start), start);
+        start = pos + 1;
+    }
+
+    // Candidate words: the storable tokens that would save the most characters
+    std::vector<const WordCounter::Entry*> candidates;
+    for (const auto& token : tokens.slots())
+        if (token.count != 0 && isStorable(token.word))
+            candidates.push_back(&token);
+    auto saving = [](const WordCounter::Entry* token) { return token->count * (token->word.size() - 1); };
+    size_t kept = std::min(words, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(kept), candidates.end(),
+        [&saving](const WordCounter::Entry* l, const WordCounter::Entry* r) {
+            return saving(l) != saving(r) ? saving(l) > saving(r) : l->first < r->first;
+        });
+    candidates.resize(kept);
+
+    // Every byte in the text and every base character, then the words
+    std::vector<Entry> entries;
+    for (int c = 0; c < 256; ++c)
+        if ((byteCounts[c] != 0 && c != '\\') || isBaseChar(c))
+            entries.push_back(Entry{std::string(1, static_cast<char>(c)), 0});
+    for (const auto* candidate : candidates)
+        entries.push_back(Entry{std::string(candidate->word), 0});
+
+    // Count how often the greedy encoder uses each of them
+    std::vector<uint64_t> uses = countUses(text, entries, CompressionTable::Greedy);
+
+    // Characters always stay (with at least a weight of 1); unused words go
+    std::vector<Entry> weighed;
+    for (size_t index = 0; index < entries.size(); ++index) {
+        if (entries[index].text.size() == 1)
+            weighed.push_back(Entry{entries[index].text, std::max<uint64_t>(uses[index], 1)});
+        else if (uses[index] != 0)
+            weighed.push_back(Entry{entries[index].text, uses[index]});
+    }
+    return weighed;
+}
+
+std::vector<TableGenerator::Entry> TableGenerator::weighFrequencies(CSVFile* chars, CSVFile* words, size_t wordCount) {
+
+    // Reads the (text, percentage) rows of a frequency CSV, skipping the header and anything unreadable
+    auto readRows = [](CSVFile* file) {
+        std::vector<std::pair<std::string, double>> rows;
+        file->readViews();
+        for (size_t index = 0; index < file->getRowCount(); ++index) {
+            auto row = file->getRow(index);
+            if (row.size() < 2)
+                continue;
+            std::string number(row[1]);
+            char *end = nullptr;
+            double percent = std::strtod(number.c_str(), &end);
+            if (end == number.c_str() || !std::isfinite(percent) || percent < 0.0)
+                continue;
+            std::string text(row[0]);
+            if (text == "<space>") text = " ";
+            if (text == "<newline>") text = "\n";
+            rows.emplace_back(text, percent);
+        }
+        return rows;
+    };
+
+    // Character percentages (per 100 characters of text)
+    double charWeights[256] = {};
+    bool hasChar[256] = {};
+    if (chars != nullptr) {
+        for (const auto& [text, percent] : readRows(chars)) {
+            if (text.size() != 1 || text[0] == '\\')
+                continue;
+            charWeights[static_cast<unsigned char>(text[0])] = percent;
+            hasChar[static_cast<unsigned char>(text[0])] = true;
+        }
+    }
+
+    // Roughly one word per space or newline (a sixth of all characters if that is unknown)
+    double wordsPerChar = (charWeights[static_cast<unsigned char>(' ')] + charWeights[static_cast<unsigned char>('\n')]) / 100.0;
+    if (wordsPerChar <= 0.0)
+        wordsPerChar = 1.0 / 6.0;
+
+    // Pick the words that would save the most characters
+    std::vector<std::pair<std::string, double>> candidates;
+    if (words != nullptr)
+        for (auto& row : readRows(words))
+            if (row.first.size() >= 2 && isStorable(row.first))
+                candidates.push_back(std::move(row));
+    size_t kept = std::min(wordCount, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(kept), candidates.end(),
+        [](const auto& l, const auto& r) { return l.second * (l.first.size() - 1) > r.second * (r.first.size() - 1); });
+    candidates.resize(kept);
+
+    // Each use of a word (per 100 characters) replaces a use of each of its characters
+    std::vector<Entry> entries;
+    for (const auto& [text, percent] : candidates) {
+        double uses = percent * wordsPerChar;
+        entries.push_back(Entry{text, static_cast<uint64_t>(std::llround(uses * 1e6))});
+        for (char c : text) {
+            charWeights[static_cast<unsigned char>(c)] -= uses;
+            hasChar[static_cast<unsigned char>(c)] = true;
+        }
+    }
+
+    // Without character frequencies, spaces still separate every word
+    if (chars == nullptr)
+        charWeights[static_cast<unsigned char>(' ')] = 100.0 * wordsPerChar;
+
+    // The characters go first (with at least a weight of 1), including every base character
+    std::vector<Entry> weighed;
+    for (int c = 0; c < 256; ++c)
+        if (hasChar[c] || isBaseChar(c))
+            weighed.push_back(Entry{std::string(1, static_cast<char>(c)), static_cast<uint64_t>(std::max<long long>(std::llround(std::max(charWeights[c], 0.0) * 1e6), 1))});
+    for (auto& entry : entries)
+        if (entry.weight != 0)
+            weighed.push_back(std::move(entry));
+    return weighed;
+}
+
+/// @brief Sorts the suffixes of a text by their first bytes (prefix doubling with radix sorts).
+/// @param text The text (shorter than 4 GiB).
+/// @param depth How many leading bytes decide the order; suffixes that agree on all of them end up in any order.
+/// @return The suffix start positions, in order.
+static std::vector<uint32_t> sortSuffixes(std::string_view text, size_t depth) {
+
+    // Sort by the first byte, which is also the first rank
+    size_t size = text.size();
+    std::vector<uint32_t> suffixes(size), rank(size), nextRank(size), bySecond(size);
+    std::vector<uint32_t> count(std::max<size_t>(size, 256) + 1, 0);
+    for (size_t pos = 0; pos < size; ++pos)
+        ++count[static_cast<unsigned char>(text[pos]) + 1];
+    for (size_t value = 1; value < count.size(); ++value)
+        count[value] += count[value - 1];
+    for (size_t pos = 0; pos < size; ++pos) {
+        rank[pos] = static_cast<unsigned char>(text[pos]);
+        suffixes[count[rank[pos]]++] = static_cast<uint32_t>(pos);
+    }
+    size_t classes = 256;
+
+    // Each round orders by twice as many bytes: the rank of the first half, then the rank of the second half
+    for (size_t half = 1; half < depth && size > 0; half *= 2) {
+
+        // Order by the second half (suffixes too short to have one come first)
+        size_t filled = 0;
+        for (size_t pos = size - std::min(half, size); pos < size; ++pos)
+            bySecond[filled++] = static_cast<uint32_t>(pos);
+        for (uint32_t suffix : suffixes)
+            if (suffix >= half)
+                bySecond[filled++] = static_cast<uint32_t>(suffix - half);
+
+        // Then stably by the first half
+        std::fill(count.begin(), count.begin() + static_cast<std::ptrdiff_t>(classes + 1), 0);
+        for (size_t pos = 0; pos < size; ++pos)
+            ++count[rank[pos] + 1];
+        for (size_t value = 1; value <= classes; ++value)
+            count[value] += count[value - 1];
+        for (uint32_t suffix : bySecond)
+            suffixes[count[rank[suffix]]++] = suffix;
+
+        // Suffixes that agree on both halves share a rank
+        auto secondRank = [&](uint32_t suffix) { return suffix + half < size ? int64_t(rank[suffix + half]) : int64_t(-1); };
+        nextRank[suffixes[0]] = 0;
+        for (size_t index = 1; index < size; ++index) {
+            uint32_t previous = suffixes[index - 1], current = suffixes[index];
+            bool same = rank[previous] == rank[current] && secondRank(previous) == secondRank(current);
+            nextRank[current] = nextRank[previous] + (same ? 0 : 1);
+        }
+        rank.swap(nextRank);
+        classes = rank[suffixes[size - 1]] + 1;
+
+        // Every suffix already has its own rank
+        if (classes == size)
+            break;
+    }
+    return suffixes;
+}
+
+/// @brief Takes evenly spaced slices of a text, each starting and ending at a word boundary.
+/// @param text The text.
+/// @param budget The total size wanted.
+/// @param storage Holds the joined slices.
+/// @return The text itself if it fits the budget, otherwise the slices joined with newlines.
+static std::string_view sampleText(std::string_view text, size_t budget, std::string& storage) {
+    if (text.size() <= budget)
+        return text;
+
+    // Sixty-four slices spread over the whole text
+    const size_t slices = 64;
+    size_t sliceSize = budget / slices;
+    storage.clear();
+    for (size_t slice = 0; slice < slices; ++slice) {
+        size_t start = text.find_first_of(" \n", slice * (text.size() / slices));
+        if (start == std::string_view::npos)
+            break;
+        size_t end = text.find_last_of(" \n", std::min(start + sliceSize, text.size() - 1));
+        if (end > start) {
+            storage.append(text.substr(start + 1, end - start));
+            storage += '\n';
+        }
+    }
+    return storage;
+}
+
+std::vector<TableGenerator::Entry> TableGenerator::mineText(std::string_view text, size_t entries, CompressionTable::Parse parse, unsigned maxBits) {
+
+    // Train on (a sample of) the text
+    std::string storage;
+    std::string_view sample = sampleText(text, TrainSampleSize, storage);
+    bool wordWise = parse == CompressionTable::Greedy || parse == CompressionTable::Optimal;
+
+    // The single characters: every byte of the text and the base characters
+    uint64_t byteCounts[256] = {};
+    for (char c : text)
+        ++byteCounts[static_cast<unsigned char>(c)];
+    std::vector<Entry> chars;
+    for (int c = 0; c < 256; ++c)
+        if ((byteCounts[c] != 0 && c != '\\') || isBaseChar(c))
+            chars.push_back(Entry{std::string(1, static_cast<char>(c)), std::max<uint64_t>(byteCounts[c], 1)});
+
+    // What each character costs on its own (its Huffman code length)
+    double charBits[256] = {};
+    auto priceChars = [&charBits, &chars, maxBits](const std::vector<uint64_t>& weights) {
+        std::vector<uint8_t> lengths = codeLengths(weights, maxBits);
+        for (size_t index = 0; index < chars.size(); ++index)
+            charBits[static_cast<unsigned char>(chars[index].text[0])] = lengths[index];
+        return lengths;
+    };
+    std::vector<uint64_t> charWeights;
+    for (const auto& entry : chars)
+        charWeights.push_back(entry.weight);
+    priceChars(charWeights);
+    auto spelledBits = [&charBits](std::string_view candidate) {
+        double bits = 0.0;
+        for (char c : candidate)
+            bits += charBits[static_cast<unsigned char>(c)];
+        return bits;
+    };
+
+    // Sort the sample's suffixes and find the common prefix of each neighbouring pair
+    std::vector<uint32_t> suffixes = sortSuffixes(sample, MaxEntryLength);
+    std::vector<uint32_t> common(sample.size() + 1, 0);
+    for (size_t index = 1; index < suffixes.size(); ++index) {
+        size_t a = suffixes[index - 1], b = suffixes[index], length = 0;
+        while (length < MaxEntryLength && a + length < sample.size() && b + length < sample.size() && sample[a + length] == sample[b + length])
+            ++length;
+        common[index] = static_cast<uint32_t>(length);
+    }
+
+    // Every repeated substring is the shared prefix of a run of neighbouring suffixes. Walk those runs with a stack
+    // and score each: its occurrences times what it saves over spelling it out (a code of about log2(size/count) bits)
+    struct Candidate {
+        double score;
+        uint32_t pos, length;
+        bool operator>(const Candidate& other) const { return score > other.score; }
+    };
+    const size_t keep = 3 * entries;
+    std::vector<Candidate> best;
+    auto consider = [&](uint32_t length, size_t first, size_t last) {
+        size_t count = last - first + 1;
+        std::string_view candidate = sample.substr(suffixes[first], length);
+        if (length < 2 || count < 3 || !isStorable(candidate))
+            return;
+        if (wordWise && candidate.substr(0, length - 1).find_first_of(" \n") != std::string_view::npos)
+            return;
+        double score = count * (spelledBits(candidate) - std::log2(double(sample.size()) / count));
+        if (score <= 0.0 || (best.size() == keep && score <= best.front().score))
+            return;
+        if (best.size() == keep) {
+            std::pop_heap(best.begin(), best.end(), std::greater<>());
+            best.pop_back();
+        }
+        best.push_back(Candidate{score, suffixes[first], length});
+        std::push_heap(best.begin(), best.end(), std::greater<>());
+    };
+    std::vector<std::pair<uint32_t, size_t>> open{{0, 0}};
+    for (size_t index = 1; index <= suffixes.size(); ++index) {
+        size_t first = index - 1;
+        while (open.back().first > common[index]) {
+            first = open.back().second;
+            consider(open.back().first, first, index - 1);
+            open.pop_back();
+        }
+        if (open.back().first < common[index])
+            open.emplace_back(common[index], first);
+    }
+
+    // The best candidates, best first
+    std::sort(best.begin(), best.end(), std::greater<>());
+    std::vector<Entry> picked;
+    for (const auto& candidate : best)
+        picked.push_back(Entry{std::string(sample.substr(candidate.pos, candidate.length)), 0});
+
+    // Refine by encoding the sample: entries that overlap or shadow each other are only credited for real uses
+    for (int round = 0; round < 3 && !picked.empty(); ++round) {
+        std::vector<Entry> table = chars;
+        table.insert(table.end(), picked.begin(), picked.end());
+        std::vector<uint64_t> uses = countUses(sample, table, parse);
+        for (auto& use : uses)
+            use = std::max<uint64_t>(use, 1);
+        std::vector<uint8_t> lengths = priceChars(uses);
+
+        // Net bits saved by each entry: its uses times (spelled-out bits - its own code bits)
+        std::vector<std::pair<double, size_t>> savings;
+        for (size_t index = 0; index < picked.size(); ++index) {
+            size_t slot = chars.size() + index;
+            double saved = double(uses[slot]) * (spelledBits(picked[index].text) - lengths[slot]);
+            if (uses[slot] > 1 && saved > 0.0)
+                savings.emplace_back(saved, index);
+        }
+        std::sort(savings.begin(), savings.end(), [](const auto& l, const auto& r) { return l.first > r.first; });
+        savings.resize(std::min(savings.size(), round == 0 ? 2 * entries : entries));
+        std::vector<Entry> kept;
+        for (const auto& saving : savings)
+            kept.push_back(std::move(picked[saving.second]));
+        picked.swap(kept);
+    }
+
+    // Weigh the final table on the whole text
+    std::vector<Entry> table = chars;
+    table.insert(table.end(), picked.begin(), picked.end());
+    std::vector<uint64_t> uses = countUses(text, table, parse);
+    std::vector<Entry> weighed;
+    for (size_t index = 0; index < table.size(); ++index) {
+        if (index < chars.size())
+            weighed.push_back(Entry{table[index].text, std::max<uint64_t>(uses[index], 1)});
+        else if (uses[index] != 0)
+            weighed.push_back(Entry{table[index].text, uses[index]});
+    }
+    return weighed;
+}
+
+std::vector<uint8_t> TableGenerator::codeLengths(const std::vector<uint64_t>& weights, unsigned maxBits) {
+
+    // Check that the codes fit
+    size_t count = weights.size();
+    if (maxBits == 0 || maxBits > CompressionTable::MaxCodeLength)
+        throw std::runtime_error("Invalid code length limit: " + std::to_string(maxBits));
+    if (maxBits < 64 && count > (uint64_t(1) << maxBits))
+        throw std::runtime_error("Too many table entries (" + std::to_string(count) + ") for codes of at most " + std::to_string(maxBits) + " bits!");
+
+    // One symbol still needs a code to be written at all
+    std::vector<uint8_t> lengths(count, 0);
+    if (count <= 1) {
+        std::fill(lengths.begin(), lengths.end(), 1);
+        return lengths;
+    }
+
+    // Package-merge: each node is a leaf (a symbol) or a package of two nodes from the previous list
+    struct Node {
+        uint64_t weight;
+        int32_t symbol;        // -1 for a package
+        int32_t left, right;   // The packaged nodes
+    };
+    std::vector<Node> nodes;
+    std::vector<int32_t> leaves(count);
+    for (size_t symbol = 0; symbol < count; ++symbol)
+        leaves[symbol] = static_cast<int32_t>(symbol);
+    std::stable_sort(leaves.begin(), leaves.end(), [&weights](int32_t l, int32_t r) { return weights[l] < weights[r]; });
+    for (size_t index = 0; index < count; ++index)
+        nodes.push_back(Node{weights[leaves[index]], leaves[index], -1, -1});
+    for (size_t index = 0; index < count; ++index)
+        leaves[index] = static_cast<int32_t>(index);
+
+    // Package the current list in pairs and merge the packages with the leaves, once per extra bit of depth
+    std::vector<int32_t> list = leaves, merged;
+    for (unsigned depth = 1; depth < maxBits; ++depth) {
+        merged.clear();
+        size_t leaf = 0;
+        for (size_t pair = 0; pair + 1 < list.size(); pair += 2) {
+            nodes.push_back(Node{nodes[list[pair]].weight + nodes[list[pair + 1]].weight, -1, list[pair], list[pair + 1]});
+            int32_t package = static_cast<int32_t>(nodes.size() - 1);
+            while (leaf < count && nodes[leaves[leaf]].weight <= nodes[package].weight)
+                merged.push_back(leaves[leaf++]);
+            merged.push_back(package);
+        }
+        while (leaf < count)
+            merged.push_back(leaves[leaf++]);
+        list.swap(merged);
+    }
+
+    // The cheapest 2n - 2 nodes of the last list make the code: each appearance of a symbol adds a bit to its length
+    std::vector<int32_t> stack(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(2 * count - 2));
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.symbol >= 0)
+            ++lengths[node.symbol];
+        else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+    return lengths;
+}
+
+std::vector<std::vector<std::string>> TableGenerator::buildRows(const std::vector<Entry>& entries, unsigned maxBits, uint64_t& payloadBits) {
+
+    // Give every entry its length
+    std::vector<uint64_t> weights;
+    for (const auto& entry : entries)
+        weights.push_back(std::max<uint64_t>(entry.weight, 1));
+    std::vector<uint8_t> lengths = codeLengths(weights, maxBits);
+
+    // Shortest codes first (heaviest first within a length)
+    std::vector<size_t> order(entries.size());
+    for (size_t index = 0; index < order.size(); ++index)
+        order[index] = index;
+    std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+        return lengths[l] != lengths[r] ? lengths[l] < lengths[r] : weights[l] > weights[r];
+    });
+
+    // Canonical codes: each code is the previous one plus one, shifted left when the length grows
+    std::vector<std::vector<std::string>> rows;
+    uint64_t code = 0;
+    unsigned length = 0;
+    payloadBits = 0;
+    for (size_t index : order) {
+        code <<= lengths[index] - length;
+        length = lengths[index];
+        std::string bits;
+        for (unsigned bit = length; bit-- > 0;)
+            bits += ((code >> bit) & 1) ? '1' : '0';
+        rows.push_back({toCell(entries[index].text), bits});
+        payloadBits += weights[index] * length;
+        ++code;
+    }
+    return rows;
+}
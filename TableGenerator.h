@@ -0,0 +1,80 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+#include "File.h"
+
+/// @brief Static helpers that build compression tables from frequency data (Don't create an object!)
+/// @note Entries are weighed by how often the encoder would use them, then given length-limited Huffman code lengths
+/// @note (package-merge) and canonical codes, so any table produced is prefix-free and at most maxBits deep.
+class TableGenerator {
+    public:
+
+        /// @brief A candidate table entry.
+        struct Entry {
+            std::string text;     // The entry text (raw: a real space or newline, not <space>/<newline>)
+            uint64_t weight = 0;  // How often it is expected to be used (relative)
+        };
+
+        /// @brief The number of multi-character entries a generated table gets by default.
+        static constexpr size_t DefaultWords = 200;
+
+        /// @brief Weighs the entries of a table for a text, by running the greedy encoder over it.
+        /// @param text The text (normalized as compression would).
+        /// @param words The number of multi-character entries to consider.
+        /// @return Every byte in the text, every printable ASCII character, tab and newline, and the words the encoder actually used.
+        /// @note Candidate words are the whole tokens (split at ' ' and '\n') that save the most characters.
+        /// @note Single characters are kept even when unused (weight 1), so the table still covers the text.
+        static std::vector<Entry> weighText(std::string_view text, size_t words);
+
+        /// @brief Weighs the entries of a table from 'gc' and 'gw' output.
+        /// @param chars The character frequencies ('gc' CSV), or nullptr.
+        /// @param words The word frequencies ('gw' CSV), or nullptr.
+        /// @param wordCount The number of multi-character entries to pick.
+        /// @return The characters and the best words, weighed per character of text.
+        /// @note Without a text to encode, each word's uses are taken off the characters it contains, assuming one word
+        /// @note per space or newline. Printable ASCII, tab and newline are always included, like the bytes of the chosen words.
+        static std::vector<Entry> weighFrequencies(CSVFile* chars, CSVFile* words, size_t wordCount);
+
+        /// @brief The number of multi-character entries a trained table gets by default.
+        static constexpr size_t DefaultEntries = 500;
+
+        /// @brief The longest entry training considers.
+        static constexpr size_t MaxEntryLength = 32;
+
+        /// @brief Larger texts are trained on evenly spaced slices adding up to this size (bounds the suffix array).
+        static constexpr size_t TrainSampleSize = size_t(4) << 20;
+
+        /// @brief Picks the multi-character entries that save the most bits, by mining frequent substrings.
+        /// @param text The text (normalized as compression would).
+        /// @param entries The most multi-character entries to keep (the size budget).
+        /// @param parse The parse the table will be used with (LongestMatch and LazyMatch allow entries across words).
+        /// @param maxBits The longest allowed code.
+        /// @return Every byte in the text, every printable ASCII character, tab and newline, and the chosen entries,
+        /// @return weighed by how often the encoder uses them on the whole text.
+        /// @note Candidates are the repeated substrings of a suffix array over (a sample of) the text, scored by
+        /// @note frequency times the bits of their characters minus the bits of their own code. The best are then
+        /// @note refined over a few rounds of actually encoding the sample, which accounts for overlaps between them.
+        static std::vector<Entry> mineText(std::string_view text, size_t entries, CompressionTable::Parse parse, unsigned maxBits);
+
+        /// @brief Computes optimal prefix code lengths no longer than a limit (package-merge).
+        /// @param weights The weight of each symbol (at least 1).
+        /// @param maxBits The longest allowed code.
+        /// @return The code length of each symbol.
+        /// @note Throws if there are more symbols than 2^maxBits codes.
+        static std::vector<uint8_t> codeLengths(const std::vector<uint64_t>& weights, unsigned maxBits);
+
+        /// @brief Builds the rows of a table CSV.
+        /// @param entries The weighed entries.
+        /// @param maxBits The longest allowed code.
+        /// @param payloadBits Receives the sum of weight times code length.
+        /// @return One row per entry (text and canonical code), shortest codes first, quoted as CSVFile reads them back.
+        static std::vector<std::vector<std::string>> buildRows(const std::vector<Entry>& entries, unsigned maxBits, uint64_t& payloadBits);
+};
@@ -0,0 +1,97 @@
+// ---------------------- Project Includes ----------------------
+#include "TopWords.h"
+
+// ---------------------- System Includes ----------------------
+#include <algorithm>
+#include <stdexcept>
+
+// Note: Function documentations listed in header file
+
+TopWords::TopWords(size_t capacity) : m_capacity(capacity) {
+
+    // The heap stores 32-bit counter indices
+    if (capacity == 0 || capacity > UINT32_MAX)
+        throw std::runtime_error("Invalid top word capacity: " + std::to_string(capacity));
+
+    // Reserve everything now so the counters' strings stay put
+    m_counters.reserve(capacity);
+    m_heap.reserve(capacity);
+    m_heapPos.reserve(capacity);
+    m_index.reserve(capacity);
+}
+
+void TopWords::add(std::string_view word) {
+    m_total++;
+
+    // A tracked word: count it and let it sink in the heap
+    auto found = m_index.find(word);
+    if (found != m_index.end()) {
+        m_counters[found->second].count++;
+        siftDown(m_heapPos[found->second]);
+        return;
+    }
+
+    // A free counter: a count of 1 is the smallest possible, so it rises past every larger count in the heap
+    if (m_counters.size() < m_capacity) {
+        uint32_t index = static_cast<uint32_t>(m_counters.size());
+        m_counters.push_back(Estimate{std::string(word), 1, 0});
+        m_index.emplace(m_counters[index].word, index);
+        size_t pos = m_heap.size();
+        m_heap.push_back(index);
+        m_heapPos.push_back(0);
+        while (pos > 0 && m_counters[m_heap[(pos - 1) / 2]].count > 1) {
+            m_heap[pos] = m_heap[(pos - 1) / 2];
+            m_heapPos[m_heap[pos]] = static_cast<uint32_t>(pos);
+            pos = (pos - 1) / 2;
+        }
+        m_heap[pos] = index;
+        m_heapPos[index] = static_cast<uint32_t>(pos);
+        return;
+    }
+
+    // Take over the counter with the smallest count; its count becomes the new word's possible error
+    uint32_t index = m_heap[0];
+    Estimate& counter = m_counters[index];
+    m_index.erase(counter.word);
+    counter.word.assign(word);
+    counter.error = counter.count;
+    counter.count++;
+    m_index.emplace(counter.word, index);
+    siftDown(0);
+}
+
+void TopWords::siftDown(size_t pos) {
+
+    // Swap with the smaller child until both children are at least as large
+    uint32_t index = m_heap[pos];
+    uint64_t count = m_counters[index].count;
+    while (true) {
+        size_t child = 2 * pos + 1;
+        if (child >= m_heap.size())
+            break;
+        if (child + 1 < m_heap.size() && m_counters[m_heap[child + 1]].count < m_counters[m_heap[child]].count)
+            child++;
+        if (m_counters[m_heap[child]].count >= count)
+            break;
+        m_heap[pos] = m_heap[child];
+        m_heapPos[m_heap[pos]] = static_cast<uint32_t>(pos);
+        pos = child;
+    }
+    m_heap[pos] = index;
+    m_heapPos[index] = static_cast<uint32_t>(pos);
+}
+
+std::vector<TopWords::Estimate> TopWords::top(size_t k) const {
+
+    // Order the counters by count, then by how sure each count is
+    std::vector<Estimate> result(m_counters);
+    auto order = [](const Estimate& l, const Estimate& r) {
+        if (l.count != r.count) return l.count > r.count;
+        if (l.error != r.error) return l.error < r.error;
+        return l.word < r.word;
+    };
+    k = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k), result.end(), order);
+    result.resize(k);
+    return result;
+}
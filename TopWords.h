@@ -0,0 +1,74 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief This class keeps a Space-Saving summary of the most frequent words in a stream.
+/// @note Memory is fixed by the capacity, however many distinct words the stream has. Once every counter is in use,
+/// @note a new word takes over the counter with the smallest count and inherits that count as its possible error.
+/// @note Guarantees (N words seen, m counters): each estimate is at most min-count <= N / m above the true count and
+/// @note never below it, and every word that occurs more than N / m times has a counter.
+class TopWords {
+public:
+
+    /// @brief An estimated word count.
+    struct Estimate {
+        std::string word;     // The word
+        uint64_t count = 0;   // Estimated occurrences (never below the true count)
+        uint64_t error = 0;   // How far above the true count the estimate can be
+    };
+
+    /// @brief The constructor for TopWords.
+    /// @param capacity The number of words tracked at once (at least 1).
+    explicit TopWords(size_t capacity);
+
+    // The index views the counters' own strings
+    TopWords(const TopWords&) = delete;
+    TopWords& operator=(const TopWords&) = delete;
+
+    /// @brief Counts a word.
+    /// @param word The word.
+    void add(std::string_view word);
+
+    /// @brief Gets the number of words counted.
+    /// @return The stream length.
+    uint64_t total() const { return m_total; }
+
+    /// @brief Gets the largest possible error of any estimate.
+    /// @return The smallest count, once every counter is in use (0 until then: the counts are exact).
+    uint64_t maxError() const { return m_counters.size() < m_capacity ? 0 : m_counters[m_heap[0]].count; }
+
+    /// @brief Gets the most frequent words.
+    /// @param k The number of words wanted.
+    /// @return Up to k estimates, highest count first (ties: smallest error, then the word).
+    std::vector<Estimate> top(size_t k) const;
+
+private:
+
+    /// @brief Restores the heap order after the count at a heap position went up.
+    /// @param pos The heap position.
+    void siftDown(size_t pos);
+
+    /// @brief The maximum number of counters.
+    size_t m_capacity;
+
+    /// @brief The counters (reserved up front, so their strings never move).
+    std::vector<Estimate> m_counters;
+
+    /// @brief Counter indices as a min-heap on count.
+    std::vector<uint32_t> m_heap;
+
+    /// @brief The heap position of each counter.
+    std::vector<uint32_t> m_heapPos;
+
+    /// @brief The counter of each tracked word (keys view the counters' strings).
+    std::unordered_map<std::string_view, uint32_t> m_index;
+
+    /// @brief The number of words counted.
+    uint64_t m_total = 0;
+};
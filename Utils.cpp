@@ -1,5 +1,9 @@
 // ---------------------- Project Includes ----------------------
 #include "Utils.h"
+#include "WordCounter.h"
+#include "TopWords.h"
+#include "Archive.h"
+#include "Codec.h"
 
 // ---------------------- Library Includes ----------------------
 #include "Ctxt/ctxt.h"
@@ -9,6 +13,11 @@
 #include <algorithm>
 #include <string>
 #include <iomanip>
+#include <cstring>
+#include <thread>
+#include <array>
+#include <fstream>
+#include <cstdio>
 
 // Note: Function documentations listed in header file
 
@@ -86,11 +95,15 @@ void Utils::testFileIO(){
     // Create a BinaryFile object
     BinaryFile binFile("./sample/sample.bin");
 
-    // Write some data to its vector<bool>
+    // Write some data to its BitBuffer
     std::vector<bool> sampleData = {1,0,1,0,1,0,1,0,1,0,1,1,1,1,1,0,0,0,0,0};
-    binFile.setData(&sampleData);
+    BitBuffer sampleBuffer;
+    BitWriter sampleWriter(sampleBuffer);
+    for (bool bit : sampleData) sampleWriter.put(bit, 1);
+    sampleWriter.flush();
+    binFile.setData(&sampleBuffer);
 
-    ctxt("Wrote to BinaryFile's vector<bool> data:", green, false, false, true);
+    ctxt("Wrote to BinaryFile's BitBuffer data:", green, false, false, true);
 
     // Write out the file
     binFile.write();
@@ -115,7 +128,7 @@ void Utils::testFileIO(){
     {
         std::string bits;
         bits.reserve(binFile.getData()->size());
-        for (bool bit : *(binFile.getData())) bits.push_back(bit ? '1' : '0');
+        for (uint64_t i = 0; i < binFile.getData()->size(); i++) bits.push_back((*binFile.getData())[i] ? '1' : '0');
         ctxt(std::string("BinaryFile content (as bits): ") + bits, yellow, false, false, true);
     }
 
@@ -245,6 +258,206 @@ void Utils::testAccuracy(){
     ctxt("-------------------------------", red, false, false, true);
 }
 
+/// @brief A small table in both modes, so the .bin tests do not depend on which table the program was built with.
+struct TestTables {
+    std::vector<std::vector<std::string>> rows = {{"a", "0"}, {"b", "10"}, {"<space>", "110"}, {"<newline>", "111"}};
+    CSVFile csv{"", &rows};
+    CompressionTable compress{csv, CompressionTable::Compress};
+    CompressionTable decompress{csv, CompressionTable::Decompress};
+};
+
+/// @brief Checks that a .bin file's text was cut into as few blocks as the block size allows, and displays the result.
+/// @param label What the file is (starts the line displayed).
+/// @param index The file's index.
+/// @param textBytes The size of the text written.
+static void checkBlockSizes(const std::string& label, const Archive::Index& index, uint64_t textBytes){
+
+    // Every block must be cut at the block size, not left to grow with the text
+    uint64_t expectedBlocks = (textBytes + Archive::BlockSize - 1) / Archive::BlockSize;
+    bool ok = index.blocks.size() == expectedBlocks;
+    for (const Archive::Block& block : index.blocks)
+        ok = ok && block.sourceBytes <= Archive::BlockSize;
+
+    ctxt(label + ": " + std::to_string(index.blocks.size()) + " blocks (expected " + std::to_string(expectedBlocks) +
+         ", each at most " + std::to_string(Archive::BlockSize) + " bytes): " + (ok ? "OK" : "FAILED"),
+         ok ? green : red, false, false, true);
+}
+
+void Utils::testArchive(){
+    ctxt("-------------------------------", red, false, false, true);
+    ctxt("Testing .bin Blocks Without Delimiters (./sample/archive_test.bin)", cyan, true, false, true);
+
+    TestTables tables;
+
+    // More than a batch of blocks of text with no space or newline anywhere
+    std::string text;
+    while (text.size() < 20 * Archive::BlockSize + 123)
+        text += "ab";
+
+    // Write it in uneven pieces, so some of it is always held back, with different numbers of threads
+    std::string binPath = "./sample/archive_test.bin";
+    std::string txtPath = "./sample/archive_test.txt";
+    std::string firstFile;
+    for (unsigned threads : {1u, 2u, 7u}) {
+        ArchiveWriter writer(binPath, tables.compress, threads);
+        writer.write(std::string_view(text).substr(0, 1000));
+        writer.write(std::string_view(text).substr(1000));
+        writer.finish();
+
+        // Check how it was cut
+        std::ifstream bin(binPath, std::ios::binary);
+        checkBlockSizes(std::to_string(threads) + " thread(s)", Archive::readIndex(bin), text.size());
+
+        // And the file must be the same whatever the number of threads
+        bin.clear();
+        bin.seekg(0);
+        std::string file((std::istreambuf_iterator<char>(bin)), std::istreambuf_iterator<char>());
+        if (firstFile.empty()) {
+            firstFile = std::move(file);
+        } else {
+            bool sameOk = file == firstFile;
+            ctxt(std::to_string(threads) + " thread(s): same file as 1 thread: " + (sameOk ? "OK" : "FAILED"),
+                 sameOk ? green : red, false, false, true);
+        }
+    }
+
+    // And the text must come back exactly
+    Codec::decompressStream(binPath, txtPath, tables.decompress);
+    std::ifstream txt(txtPath, std::ios::binary);
+    std::string decoded((std::istreambuf_iterator<char>(txt)), std::istreambuf_iterator<char>());
+    txt.close();
+    bool roundTripOk = decoded == text;
+    ctxt(std::string("Round trip: ") + (roundTripOk ? "OK" : "FAILED"), roundTripOk ? green : red, false, false, true);
+
+    // Clean up the files written
+    std::remove(binPath.c_str());
+    std::remove(txtPath.c_str());
+
+    ctxt("-------------------------------", red, false, false, true);
+}
+
+void Utils::testStreaming(){
+    ctxt("-------------------------------", red, false, false, true);
+    ctxt("Testing Streaming Without Delimiters (./sample/stream_test.txt)", cyan, true, false, true);
+
+    TestTables tables;
+
+    // Several windows of text with no space or newline anywhere
+    std::string text;
+    while (text.size() < 3 * Codec::ChunkSize + 321)
+        text += "aab";
+    std::string txtPath = "./sample/stream_test.txt";
+    std::string binPath = "./sample/stream_test.bin";
+    std::string outPath = "./sample/stream_test_out.txt";
+    std::ofstream txt(txtPath, std::ios::binary);
+    txt.write(text.data(), static_cast<std::streamsize>(text.size()));
+    txt.close();
+
+    // Stream it through the container and check how it was cut
+    Codec::compressStream(txtPath, binPath, tables.compress);
+    std::ifstream bin(binPath, std::ios::binary);
+    checkBlockSizes("Streamed", Archive::readIndex(bin), text.size());
+    bin.close();
+
+    // And stream it back
+    Codec::decompressStream(binPath, outPath, tables.decompress);
+    std::ifstream out(outPath, std::ios::binary);
+    std::string decoded((std::istreambuf_iterator<char>(out)), std::istreambuf_iterator<char>());
+    out.close();
+    bool roundTripOk = decoded == text;
+    ctxt(std::string("Round trip: ") + (roundTripOk ? "OK" : "FAILED"), roundTripOk ? green : red, false, false, true);
+
+    // Clean up the files written
+    std::remove(txtPath.c_str());
+    std::remove(binPath.c_str());
+    std::remove(outPath.c_str());
+
+    ctxt("-------------------------------", red, false, false, true);
+}
+
+void Utils::testTableCodes(){
+    ctxt("-------------------------------", red, false, false, true);
+    ctxt("Testing Compression Table Code Checks", cyan, true, false, true);
+
+    // Each table, whether loading it for decompression should fail, and why
+    struct Case { std::string name; std::vector<std::vector<std::string>> rows; bool rejected; };
+    std::vector<Case> cases = {
+        {"Prefix-free codes", {{"a", "0"}, {"b", "10"}, {"<space>", "11"}}, false},
+        {"Duplicate code", {{"a", "0"}, {"b", "10"}, {"c", "10"}, {"<space>", "11"}}, true},
+        {"Code that prefixes a later one", {{"a", "0"}, {"b", "01"}, {"<space>", "11"}}, true},
+        {"Code that a later one prefixes", {{"b", "01"}, {"a", "0"}, {"<space>", "11"}}, true},
+    };
+
+    for (Case& test : cases) {
+
+        // Try to build the decoder
+        std::string error;
+        try {
+            CSVFile csv("./sample/codes_test.csv", &test.rows);
+            CompressionTable table(csv, CompressionTable::Decompress);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+
+        // Display whether it was rejected as expected
+        bool ok = error.empty() != test.rejected;
+        ctxt(test.name + ": " + (error.empty() ? "accepted" : "rejected (" + error + ")") + (ok ? " OK" : " FAILED"),
+             ok ? green : red, false, false, true);
+    }
+
+    ctxt("-------------------------------", red, false, false, true);
+}
+
+/// @brief Gets the text of a file that has not been extracted yet, without copying it.
+/// @param file The text file (read normally or with readMapped()).
+/// @return The mapped contents, or the stringstream's buffer from its get position on.
+static std::string_view unreadText(TextFile* file) {
+
+    // A mapped file is used as it is
+    if(file->isMapped())
+        return file->getView();
+
+    // Otherwise skip whatever was already extracted from the stringstream
+    std::string_view text = file->getData()->view();
+    std::streamoff offset = file->getData()->tellg();
+    text.remove_prefix(offset > 0 ? std::min<size_t>(static_cast<size_t>(offset), text.size()) : 0);
+    return text;
+}
+
+/// @brief Counts how often each byte value occurs in a range.
+/// @param data The bytes.
+/// @param size The number of bytes.
+/// @param counts Receives the 256 counts (added to what is already there).
+/// @note Consecutive bytes go to different sub-histograms, so a run of one byte value does not wait on its own
+/// @note previous increment (the store-to-load dependency that makes a single histogram slow).
+static void countBytes(const unsigned char* data, size_t size, uint64_t* counts) {
+
+    // Four interleaved sub-histograms
+    uint64_t sub[4][256] = {};
+
+    // Sixteen bytes per round, read as two words
+    size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        uint64_t lo, hi;
+        std::memcpy(&lo, data + pos, sizeof(lo));
+        std::memcpy(&hi, data + pos + 8, sizeof(hi));
+        for (int shift = 0; shift < 64; shift += 16) {
+            ++sub[0][(lo >> shift) & 0xFF];
+            ++sub[1][(lo >> (shift + 8)) & 0xFF];
+            ++sub[2][(hi >> shift) & 0xFF];
+            ++sub[3][(hi >> (shift + 8)) & 0xFF];
+        }
+    }
+
+    // The tail, one byte at a time
+    for (; pos < size; ++pos)
+        ++sub[0][data[pos]];
+
+    // Merge the sub-histograms
+    for (int value = 0; value < 256; ++value)
+        counts[value] += sub[0][value] + sub[1][value] + sub[2][value] + sub[3][value];
+}
+
 std::vector<std::pair<char, double>>* Utils::genCharFreqs(TextFile* file){
 
     // Check if the file has been read
@@ -255,35 +468,48 @@ std::vector<std::pair<char, double>>* Utils::genCharFreqs(TextFile* file){
     if(file->getData() == nullptr)
         throw std::runtime_error("Invalid attempt to calculate character frequencies on an empty file!");
 
-    // Initialize and define our result map
-    std::vector<std::pair<char, double>> *result = new std::vector<std::pair<char, double>>();
-    
-    // Count the occurrence of each character and keep track of total characters
-    unsigned int totalChars = 0;
-    char extracted;
-    while(file->getData()->get(extracted)){
-
-        // See if we've already encountered this character
-        auto it = std::find_if(result->begin(), result->end(), [&extracted](const std::pair<char, double>& l)
-            { return l.first == extracted; });
-
-        // If the character isn't already in our list, append it
-        if(it == result->end()){
-            result->push_back(std::make_pair(extracted, 1.0));
+    // Count straight from the mapping or the stringstream's buffer
+    std::string_view text = unreadText(file);
+    const unsigned char *data = reinterpret_cast<const unsigned char*>(text.data());
+
+    // Large inputs are split into one slice per thread; each thread fills its own histogram
+    uint64_t counts[256] = {};
+    size_t threads = std::clamp<size_t>(text.size() / ParallelSliceSize, 1, std::max(1u, std::thread::hardware_concurrency()));
+    if(threads == 1)
+        countBytes(data, text.size(), counts);
+    else {
+        std::vector<std::array<uint64_t, 256>> partial(threads);
+        std::vector<std::thread> workers;
+        size_t slice = text.size() / threads;
+        for(size_t t = 0; t < threads; t++){
+            size_t begin = t * slice, end = t + 1 == threads ? text.size() : begin + slice;
+            partial[t].fill(0);
+            workers.emplace_back(countBytes, data + begin, end - begin, partial[t].data());
         }
 
-        // Otherwise, increment that occurrence
-        else {
-            it->second++;
+        // Merge the per-thread counts
+        for(size_t t = 0; t < threads; t++){
+            workers[t].join();
+            for(int value = 0; value < 256; value++)
+                counts[value] += partial[t][value];
         }
+    }
 
-        // Increment total character count
-        totalChars++;
+    // Initialize and define our result map
+    std::vector<std::pair<char, double>> *result = new std::vector<std::pair<char, double>>();
+
+    // List the characters in order of first appearance, stopping as soon as every one has been seen
+    size_t distinct = std::count_if(std::begin(counts), std::end(counts), [](uint64_t count){ return count != 0; });
+    bool seen[256] = {};
+    for(size_t pos = 0; result->size() < distinct; pos++){
+        if(seen[data[pos]]) continue;
+        seen[data[pos]] = true;
+        result->push_back(std::make_pair(static_cast<char>(data[pos]), static_cast<double>(counts[data[pos]])));
     }
 
     // Calculate the percent makeup of each character
     for(auto & i : *result){
-        i.second = (i.second * 100.0) / totalChars;
+        i.second = (i.second * 100.0) / text.size();
     }
 
     // Sort the vector by value
@@ -307,45 +533,45 @@ std::vector<std::pair<std::string, double>>* Utils::genWordFreqs(TextFile* file)
     if(file->getData() == nullptr)
         throw std::runtime_error("Invalid attempt to calculate word frequencies on an empty file!");
 
-    // Initialize and define our result map
-    std::vector<std::pair<std::string, double>> *result = new std::vector<std::pair<std::string, double>>();
-    
-    // Count the occurrence of each word and keep track of total words
-    unsigned int totalWords = 0;
-    std::string word;
-    while(*file->getData() >> word){
-
-        // make sure it's just the word, no punctuation except '
-        word.erase(std::remove_if(word.begin(), word.end(), [](char i){ return ::ispunct(static_cast<unsigned char>(i)) && i != '\''; }), word.end());
-
-        // deal with edge case: "that's", "that'd" strip after apostrophe if it's the last character
-        if(word.length() > 2 && word[word.length() - 2] == '\''){
-
-            // if(word == "wouldn't") word = "would";
-            if(word.at(word.length()-1) == 's') word = word.substr(0, word.length() - 2);
-        }
-
-        // See if we've already encountered this word
-        auto it = std::find_if(result->begin(), result->end(), [&word](const std::pair<std::string, double>& l)
-            { return l.first == word; });
-
-        // If the word isn't already in our list, append it
-        if(it == result->end()){
-            result->push_back(std::make_pair(word, 1.0));
-        }
-
-        // Otherwise, increment that occurrence
-        else {
-            it->second++;
-        }
-
-        // Increment total word count
-        totalWords++;
+    // Split the text at word boundaries into one slice per thread
+    std::string_view text = unreadText(file);
+    size_t threads = std::clamp<size_t>(text.size() / ParallelSliceSize, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<size_t> cuts{0};
+    for(size_t t = 1; t < threads; t++)
+        cuts.push_back(WordCounter::findWordBoundary(text, std::max(cuts.back(), t * (text.size() / threads))));
+    cuts.push_back(text.size());
+
+    // Each thread counts its slice into its own table (map)
+    std::vector<WordCounter> counters(threads);
+    auto count = [&text, &cuts, &counters](size_t t){
+        WordCounter& counter = counters[t];
+        WordCounter::forEachWord(text.substr(cuts[t], cuts[t + 1] - cuts[t]), cuts[t],
+            [&counter](std::string_view word, uint64_t position){ counter.add(word, position); });
+    };
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; t++)
+        workers.emplace_back(count, t);
+    count(0);
+
+    // Merge the other tables into the first (reduce)
+    for(size_t t = 1; t < threads; t++){
+        workers[t - 1].join();
+        counters[0].merge(counters[t]);
     }
+    const WordCounter& counter = counters[0];
 
-    // Calculate the percent makeup of each word
-    for(auto & i : *result){
-        i.second = (i.second * 100.0) / totalWords;
+    // List the words in order of first appearance
+    std::vector<const WordCounter::Entry*> entries;
+    entries.reserve(counter.size());
+    for(const auto& entry : counter.slots())
+        if(entry.count != 0) entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(), [](const WordCounter::Entry* l, const WordCounter::Entry* r){ return l->first < r->first; });
+
+    // Initialize and define our result map, with the percent makeup of each word
+    std::vector<std::pair<std::string, double>> *result = new std::vector<std::pair<std::string, double>>();
+    result->reserve(entries.size());
+    for(const auto* entry : entries){
+        result->emplace_back(std::string(entry->word), (static_cast<double>(entry->count) * 100.0) / counter.total());
     }
 
     // Sort the vector by value
@@ -359,6 +585,33 @@ std::vector<std::pair<std::string, double>>* Utils::genWordFreqs(TextFile* file)
     return result;
 }
 
+std::vector<std::pair<std::string, double>>* Utils::genTopWordFreqs(TextFile* file, size_t k, size_t counters, double& maxOverestimate){
+
+    // Check if the file has been read
+    if(file->getData() == nullptr)
+        file->read();
+
+    // Check if reading was successful
+    if(file->getData() == nullptr)
+        throw std::runtime_error("Invalid attempt to calculate word frequencies on an empty file!");
+
+    // Stream every word through the summary
+    TopWords summary(std::max(k, counters));
+    WordCounter::forEachWord(unreadText(file), 0, [&summary](std::string_view word, uint64_t){ summary.add(word); });
+
+    // Convert the counts to percentages, keeping track of the largest error margin
+    std::vector<std::pair<std::string, double>> *result = new std::vector<std::pair<std::string, double>>();
+    maxOverestimate = 0.0;
+    for(auto& estimate : summary.top(k)){
+        double total = static_cast<double>(summary.total());
+        result->emplace_back(std::move(estimate.word), (static_cast<double>(estimate.count) * 100.0) / total);
+        maxOverestimate = std::max(maxOverestimate, (static_cast<double>(estimate.error) * 100.0) / total);
+    }
+
+    // Done!
+    return result;
+}
+
 double Utils::genAccuracy(TextFile* original, TextFile* decompressed){
 
     // Check if the files have been read
@@ -440,32 +693,72 @@ double Utils::genPercentReduction(TextFile* original, BinaryFile* compressed){
     if(original->getData() == nullptr || compressed->getData() == nullptr)
         throw std::runtime_error("Invalid attempt to calculate percent reduction on an empty file(s)!");
 
-    // Reset stringstream position to the beginning
-    original->getData()->clear();
-    original->getData()->seekg(0, std::ios::beg);
-
     // Calculate number of original characters
     unsigned int numOriginalChars = 0;
-    char originalChar;
-    while(original->getData()->get(originalChar))
-        numOriginalChars++;
+
+    // A mapped file already knows its length
+    if(original->isMapped())
+        numOriginalChars = original->getView().size();
+
+    else {
+
+        // Reset stringstream position to the beginning
+        original->getData()->clear();
+        original->getData()->seekg(0, std::ios::beg);
+
+        char originalChar;
+        while(original->getData()->get(originalChar))
+            numOriginalChars++;
+    }
 
     // Get the number of bits in compressed file
     unsigned int numCompressedBits = compressed->getData()->size();
 
+    return genPercentReduction(numOriginalChars, numCompressedBits);
+}
+
+double Utils::genPercentReduction(uint64_t numOriginalChars, uint64_t numCompressedBits){
+
     // Use the provided formula to calculate percent reduction
     // 100*((8 * numOriginalChars - numCompressedBits)/(8*numOriginalChars))
     if(numOriginalChars == 0) return 0.0; // Avoid division by zero, no reduction possible on empty original
     return 100.0 * ((8.0 * static_cast<double>(numOriginalChars) - static_cast<double>(numCompressedBits)) / (8.0 * static_cast<double>(numOriginalChars)));
+}
+
+// ****************** ARGUMENT UTILITIES *****************
+
+std::unordered_map<std::string, std::string> Utils::extractOptions(int& argc, char* argv[]){
+    std::unordered_map<std::string, std::string> options;
+
+    // Keep the program name and every positional argument, in order
+    int kept = 1;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+
+        // Positional argument
+        if(arg.rfind("--", 0) != 0 || arg.length() == 2){
+            argv[kept++] = argv[i];
+            continue;
+        }
 
+        // Option, with or without a value
+        size_t equals = arg.find('=');
+        if(equals == std::string::npos)
+            options[arg.substr(2)] = "";
+        else
+            options[arg.substr(2, equals - 2)] = arg.substr(equals + 1);
+    }
+
+    argc = kept;
+    return options;
 }
 
 // ****************** PRINTING UTILITIES *****************
 
 void Utils::printUsage(char* argv[]){
     ctxt("\nUsage: \n\n", red, false, false, false);
-    ctxt(std::string(argv[0]) + " <mode> <input file(s)>\n", green, false, false, true);
-    ctxt("  <mode>: \n\n    c ---- Compression mode\n    d ---- Decompression mode\n    gc --- Generate character frequencies mode\n    gw --- Generate word frequencies mode\n    help - Display more detailed information about modes\n    test - Execute test functions\n    acc -- Compare two text files' accuracy\n", yellow, false, false, true);
+    ctxt(std::string(argv[0]) + " <mode> <input file(s)> [--option=value ...]\n", green, false, false, true);
+    ctxt("  <mode>: \n\n    c ---- Compression mode\n    d ---- Decompression mode\n    gc --- Generate character frequencies mode\n    gw --- Generate word frequencies mode\n    gt --- Generate compression table mode\n    tr --- Train compression table mode\n    help - Display more detailed information about modes\n    test - Execute test functions\n    acc -- Compare two text files' accuracy\n    verify Check a .bin file's checksums without decoding it\n", yellow, false, false, true);
 }
 
 void Utils::printHelp(char* argv[]){
@@ -478,13 +771,26 @@ void Utils::printHelp(char* argv[]){
     ctxt("    Compresses the input text file using a predefined compression table.\n", blue, false, false, false);
     ctxt(std::string("    Example: ") + argv[0] + " c input.txt\n", magenta, false, false, false);
     ctxt("      Output files generated:\n", magenta, false, false, false);
-    ctxt("        - input.bin: The compressed binary output file.\n\n", yellow, false, false, true);
+    ctxt("        - input.bin: The compressed binary output file.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --parse=greedy|optimal|longest|lazy: How text is split into table entries.\n", yellow, false, false, false);
+    ctxt("          greedy (default) and optimal (fewest bits) work word by word; longest and lazy match across\n", yellow, false, false, false);
+    ctxt("          word boundaries, so table entries may contain spaces, newlines and punctuation.\n", yellow, false, false, false);
+    ctxt("        --table=path.csv: Use this compression table instead of the one built into the program.\n", yellow, false, false, false);
+    ctxt("          It is compiled to path.tft on first use; later runs map that file until the CSV changes.\n", yellow, false, false, false);
+    ctxt("        --threads=N: Encode with N threads (default: one per core). The output is the same for any N.\n\n", yellow, false, false, true);
 
     ctxt("  Decompression Mode (d):\n", dark_green, false, false, false);
     ctxt("    Decompresses the input binary file using a predefined compression table.\n", blue, false, false, false);
     ctxt(std::string("    Example: ") + argv[0] + " d input.bin\n", magenta, false, false, false);
     ctxt("      Output files generated:\n", magenta, false, false, false);
-    ctxt("        - input.txt: The decompressed text output file.\n\n", yellow, false, false, true);
+    ctxt("        - input.txt: The decompressed text output file.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --table=path.csv: Use this compression table instead of the built-in one (must match the one used to compress).\n", yellow, false, false, false);
+    ctxt("        --threads=N: Decode with N threads (default: one per core).\n", yellow, false, false, false);
+    ctxt("        --offset=N, --length=N: Only decompress this many bytes (default: the rest) from this offset (default: 0).\n", yellow, false, false, false);
+    ctxt("        --lines=A or --lines=A-B: Only decompress line A, or lines A to B (the first line is 1).\n", yellow, false, false, false);
+    ctxt("          Only the blocks holding the range are decoded, so this is fast however large the file is.\n\n", yellow, false, false, true);
 
     ctxt("  Generate Character Frequencies Mode (gc):\n", dark_green, false, false, false);
     ctxt("    Analyzes the input text file and generates a frequency table of characters.\n", blue, false, false, false);
@@ -496,7 +802,32 @@ void Utils::printHelp(char* argv[]){
     ctxt("    Analyzes the input text file and generates a frequency table of words.\n", blue, false, false, false);
     ctxt(std::string("    Example: ") + argv[0] + " gw input.txt\n", magenta, false, false, false);
     ctxt("      Output files generated:\n", magenta, false, false, false);
-    ctxt("        - input_word_freqs.csv: A CSV file listing each word and its frequency percentage.\n\n", yellow, false, false, true);
+    ctxt("        - input_word_freqs.csv: A CSV file listing each word and its frequency percentage.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --top=K: Only estimate the K most frequent words, in fixed memory (for corpora with too many distinct words to count).\n", yellow, false, false, false);
+    ctxt("          The CSV has the same columns; the console reports how far above the true frequency the estimates can be.\n", yellow, false, false, false);
+    ctxt("        --error=P: With --top, track enough words that no estimate is more than P percent too high (default: 4*K words).\n\n", yellow, false, false, true);
+
+    ctxt("  Generate Table Mode (gt):\n", dark_green, false, false, false);
+    ctxt("    Builds a compression table tuned to a text: every character it contains plus the words that save the most,\n", blue, false, false, false);
+    ctxt("    with optimal (length-limited Huffman) code lengths. 'gc' and/or 'gw' output can be given instead of the text.\n", blue, false, false, false);
+    ctxt(std::string("    Example: ") + argv[0] + " gt input.txt  or  " + argv[0] + " gt input_char_freqs.csv input_word_freqs.csv\n", magenta, false, false, false);
+    ctxt("      Output files generated:\n", magenta, false, false, false);
+    ctxt("        - input_table.csv: The table, for use with --table=input_table.csv in 'c' and 'd' modes.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --words=N: The number of multi-character entries to consider (default 200).\n", yellow, false, false, false);
+    ctxt("        --max-bits=L: The longest code to assign (default 32; shorter limits keep decoding fast).\n\n", yellow, false, false, true);
+
+    ctxt("  Train Table Mode (tr):\n", dark_green, false, false, false);
+    ctxt("    Like 'gt', but mines the text for the substrings that save the most bits (word fragments such as 'ing ' and,\n", blue, false, false, false);
+    ctxt("    for the longest and lazy parses, phrases across words) instead of only taking whole words.\n", blue, false, false, false);
+    ctxt(std::string("    Example: ") + argv[0] + " tr input.txt --parse=lazy\n", magenta, false, false, false);
+    ctxt("      Output files generated:\n", magenta, false, false, false);
+    ctxt("        - input_table.csv: The table, for use with --table=input_table.csv (and the same --parse) in 'c' and 'd' modes.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --entries=N: The most multi-character entries to keep (default 500).\n", yellow, false, false, false);
+    ctxt("        --parse=greedy|optimal|longest|lazy: The parse the table is trained for (default greedy).\n", yellow, false, false, false);
+    ctxt("        --max-bits=L: The longest code to assign (default 32).\n\n", yellow, false, false, true);
 
     ctxt("  Help Mode (help):\n", dark_green, false, false, false);
     ctxt("    Displays this detailed usage information.\n", magenta, false, false, true);
@@ -511,6 +842,14 @@ void Utils::printHelp(char* argv[]){
     ctxt("      Output:\n", magenta, false, false, false);
     ctxt("        - Displays the accuracy percentage in the console.\n\n", yellow, false, false, true);
 
+    ctxt("  Verify Mode (verify):\n", dark_green, false, false, false);
+    ctxt("    Checks a .bin file's header, index and every block against their CRC-32C checksums, without decoding.\n", blue, false, false, false);
+    ctxt(std::string("    Example: ") + argv[0] + " verify input.bin\n", magenta, false, false, false);
+    ctxt("      Output:\n", magenta, false, false, false);
+    ctxt("        - Reports whether the file is intact, or which blocks (text ranges) are damaged. Exits with 1 if any are.\n", yellow, false, false, false);
+    ctxt("      Options:\n", magenta, false, false, false);
+    ctxt("        --threads=N: Check with N threads (default: one per core).\n\n", yellow, false, false, true);
+
     ctxt("Note:\n", dark_red, true, false, false);
     ctxt("  - Make sure that the input files exist and are accessible.\n", yellow, false, false, false);
     ctxt("  - The program will generate output files in the same directory as the input file if no output destination specified.\n", yellow, false, false, false);
@@ -30,6 +30,18 @@ class Utils {
         /// @note This function writes to cout.
         static void testAccuracy();
 
+        /// @brief Test the .bin container on text with no space or newline to cut blocks at.
+        /// @note This function writes to cout and to ./sample/ (the files it writes are removed again).
+        static void testArchive();
+
+        /// @brief Test the streaming pipelines on a file with no space or newline to cut windows or blocks at.
+        /// @note This function writes to cout and to ./sample/ (the files it writes are removed again).
+        static void testStreaming();
+
+        /// @brief Test that compression tables whose codes cannot be decoded are rejected.
+        /// @note This function writes to cout.
+        static void testTableCodes();
+
         // ***************** FILE PATH UTILITIES *****************
         
         /// @brief Extracts the filename from a given path.
@@ -49,6 +61,14 @@ class Utils {
         /// @note If the filename has no extension, it is returned unchanged.
         static std::string removeFileExtension(std::string filename);
 
+        // ***************** ARGUMENT UTILITIES *****************
+
+        /// @brief Pulls every option ("--key=value", or "--key" for an empty value) out of the command line arguments.
+        /// @param argc The argument count; lowered by the number of options removed.
+        /// @param argv The arguments; the remaining ones are moved up so positional arguments keep their indices.
+        /// @return A map of option keys (without the leading "--") to their values. A repeated key keeps its last value.
+        static std::unordered_map<std::string, std::string> extractOptions(int& argc, char* argv[]);
+
         // ***************** OTHER UTILITIES *****************
 
         /// @brief Compares two vectors for equality.
@@ -70,18 +90,34 @@ class Utils {
             return true;
         }
 
+        /// @brief Inputs are only split across threads once every thread gets at least this many bytes.
+        static constexpr size_t ParallelSliceSize = size_t(4) << 20;
+
         /// @brief Generates the relative character frequencies for the given text file.
-        /// @param file The text file to process.
+        /// @param file The text file to process (read normally or with readMapped()).
         /// @return A map of characters to their percent frequency / 100.
         /// @note The caller is responsible for deleting the returned map.
+        /// @note Counts into a 256-bin histogram; large inputs are counted by several threads.
         static std::vector<std::pair<char, double>>* genCharFreqs(TextFile*);
 
         /// @brief Generates the relative word frequencies for the given text file.
-        /// @param file The text file to process.
+        /// @param file The text file to process (read normally or with readMapped()).
         /// @return A map of words to their percent frequency / 100.
         /// @note The caller is responsible for deleting the returned map.
+        /// @note Large inputs are split at word boundaries; each thread counts into its own WordCounter and the tables are merged.
         static std::vector<std::pair<std::string, double>>* genWordFreqs(TextFile*);
 
+        /// @brief Estimates the most frequent words of the given text file in fixed memory.
+        /// @param file The text file to process (read normally or with readMapped()).
+        /// @param k The number of words to report.
+        /// @param counters The number of words tracked at once (at least k; more counters give tighter estimates).
+        /// @param maxOverestimate Receives how far (in percent) the least certain of the returned estimates can be above
+        /// @param maxOverestimate its word's true frequency.
+        /// @return Up to k pairs of a word and its estimated percent frequency, like genWordFreqs().
+        /// @note The caller is responsible for deleting the returned vector.
+        /// @note Words are split exactly as in genWordFreqs(), but counted with a TopWords (Space-Saving) summary.
+        static std::vector<std::pair<std::string, double>>* genTopWordFreqs(TextFile* file, size_t k, size_t counters, double& maxOverestimate);
+
         /// @brief Generates the accuracy of a decompressed file against the original file.
         /// @note This function assumes that both files are text files.
         /// @param original The original text file.
@@ -98,6 +134,13 @@ class Utils {
         /// @note This function assumes that the text file uses 1 byte per character.
         static double genPercentReduction(TextFile*, BinaryFile*);
 
+        /// @brief Generates the percent reduction in size from a character count to a compressed bit count.
+        /// @param numOriginalChars The number of characters in the original text.
+        /// @param numCompressedBits The number of bits in the compressed payload.
+        /// @return The percent reduction in size (0.0 to 100.0).
+        /// @note If the compressed size is larger than the original, the percent reduction will be negative.
+        static double genPercentReduction(uint64_t numOriginalChars, uint64_t numCompressedBits);
+
         // ***************** PRINTING UTILITIES *****************
 
         /// @brief Prints the usage information for the program.
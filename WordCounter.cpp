@@ -0,0 +1,123 @@
+// ---------------------- Project Includes ----------------------
+#include "WordCounter.h"
+
+// ---------------------- System Includes ----------------------
+#include <algorithm>
+#include <cstring>
+
+// Note: Function documentations listed in header file
+
+WordCounter::WordCounter() : m_slots(1024) {}
+
+uint64_t WordCounter::hashOf(std::string_view word) {
+
+    // Mix in eight bytes at a time, then the tail
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = word.size() * multiplier;
+    size_t pos = 0;
+    for (; pos + 8 <= word.size(); pos += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, word.data() + pos, sizeof(chunk));
+        hash = (hash ^ chunk) * multiplier;
+        hash ^= hash >> 32;
+    }
+    if (pos < word.size()) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, word.data() + pos, word.size() - pos);
+        hash = (hash ^ chunk) * multiplier;
+        hash ^= hash >> 32;
+    }
+
+    // Final avalanche so the low bits (the slot index) depend on every byte
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void WordCounter::add(std::string_view word, uint64_t hash, uint64_t position, uint64_t count) {
+
+    // Linear probing from the home slot
+    size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        Entry& entry = m_slots[slot];
+
+        // A new word
+        if (entry.count == 0) {
+            entry.word = store(word);
+            entry.hash = hash;
+            entry.count = count;
+            entry.first = position;
+            m_total += count;
+
+            // Keep the table at most half full
+            if (++m_size * 2 > m_slots.size())
+                grow();
+            return;
+        }
+
+        // A word seen before
+        if (entry.hash == hash && entry.word == word) {
+            entry.count += count;
+            entry.first = std::min(entry.first, position);
+            m_total += count;
+            return;
+        }
+    }
+}
+
+void WordCounter::merge(const WordCounter& other) {
+    for (const Entry& entry : other.m_slots)
+        if (entry.count != 0)
+            add(entry.word, entry.hash, entry.first, entry.count);
+}
+
+void WordCounter::grow() {
+
+    // Reinsert every entry into a table twice the size (the words stay where they are in the arena)
+    std::vector<Entry> old(m_slots.size() * 2);
+    old.swap(m_slots);
+    size_t mask = m_slots.size() - 1;
+    for (const Entry& entry : old) {
+        if (entry.count == 0)
+            continue;
+        size_t slot = entry.hash & mask;
+        while (m_slots[slot].count != 0)
+            slot = (slot + 1) & mask;
+        m_slots[slot] = entry;
+    }
+}
+
+std::string_view WordCounter::store(std::string_view word) {
+
+    // Nothing to copy
+    if (word.empty())
+        return std::string_view();
+
+    // A word too long for a shared block gets a block of its own
+    if (word.size() > ArenaBlockSize / 4) {
+        m_arena.push_back(std::make_unique<char[]>(word.size()));
+        std::memcpy(m_arena.back().get(), word.data(), word.size());
+        return std::string_view(m_arena.back().get(), word.size());
+    }
+
+    // Start a new block once the current one is full
+    if (word.size() > m_arenaFree) {
+        m_arena.push_back(std::make_unique<char[]>(ArenaBlockSize));
+        m_arenaCursor = m_arena.back().get();
+        m_arenaFree = ArenaBlockSize;
+    }
+
+    // Append the word to the current block
+    std::memcpy(m_arenaCursor, word.data(), word.size());
+    std::string_view stored(m_arenaCursor, word.size());
+    m_arenaCursor += word.size();
+    m_arenaFree -= word.size();
+    return stored;
+}
+
+size_t WordCounter::findWordBoundary(std::string_view text, size_t pos) {
+    while (pos < text.size() && s_byteClass[static_cast<unsigned char>(text[pos])] != Space)
+        ++pos;
+    return std::min(pos, text.size());
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+// ---------------------- System Includes ----------------------
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <array>
+
+/// @brief This class counts words in an open-addressing hash table.
+/// @note Keys are string views into an arena owned by the counter, so a word is copied once, when it is first seen,
+/// @note and growing the table never moves any text.
+class WordCounter {
+public:
+
+    /// @brief A counted word.
+    struct Entry {
+        std::string_view word;    // The word (viewing the arena; empty slot if count is 0)
+        uint64_t hash = 0;        // hashOf(word)
+        uint64_t count = 0;       // Occurrences
+        uint64_t first = 0;       // Position of the first occurrence (for ordering ties)
+    };
+
+    /// @brief The constructor for WordCounter.
+    WordCounter();
+
+    // The entries view the counter's own arena
+    WordCounter(const WordCounter&) = delete;
+    WordCounter& operator=(const WordCounter&) = delete;
+    WordCounter(WordCounter&&) = default;
+    WordCounter& operator=(WordCounter&&) = default;
+
+    /// @brief Counts a word.
+    /// @param word The word (copied into the arena if it is new).
+    /// @param position Where it occurred; the smallest position seen is kept.
+    /// @param count The number of occurrences to add.
+    void add(std::string_view word, uint64_t position, uint64_t count = 1) { add(word, hashOf(word), position, count); }
+
+    /// @brief Adds every word of another counter to this one.
+    /// @param other The counter to merge in.
+    void merge(const WordCounter& other);
+
+    /// @brief Gets the number of distinct words.
+    /// @return The distinct word count.
+    size_t size() const { return m_size; }
+
+    /// @brief Gets the number of words counted.
+    /// @return The sum of all counts.
+    uint64_t total() const { return m_total; }
+
+    /// @brief Gets the slots of the table.
+    /// @return Every slot; the empty ones have a count of 0.
+    const std::vector<Entry>& slots() const { return m_slots; }
+
+    /// @brief Hashes a word.
+    /// @param word The word.
+    /// @return Its 64-bit hash.
+    static uint64_t hashOf(std::string_view word);
+
+    /// @brief Splits text into words the way genWordFreqs() counts them.
+    /// @tparam Callback Called as callback(std::string_view word, uint64_t position) for every word.
+    /// @param text The text.
+    /// @param base The position of the text's first byte (added to every reported position).
+    /// @note Words are separated by whitespace, as with operator>> in the "C" locale. Punctuation other than '\''
+    /// @note is removed, then a trailing "'s" is dropped from words longer than two characters. A word that is all
+    /// @note punctuation is still reported, as an empty word.
+    template <typename Callback>
+    static void forEachWord(std::string_view text, uint64_t base, Callback&& callback) {
+
+        // Scratch space for words that need cleaning
+        std::string cleaned;
+        size_t pos = 0;
+        while (pos < text.size()) {
+
+            // Skip whitespace
+            while (pos < text.size() && s_byteClass[static_cast<unsigned char>(text[pos])] == Space)
+                ++pos;
+            if (pos == text.size())
+                break;
+
+            // Find the end of the word, noting whether it has any punctuation
+            size_t start = pos;
+            bool punctuated = false;
+            for (; pos < text.size(); ++pos) {
+                uint8_t byteClass = s_byteClass[static_cast<unsigned char>(text[pos])];
+                if (byteClass == Space)
+                    break;
+                punctuated |= byteClass == Punct;
+            }
+            std::string_view word = text.substr(start, pos - start);
+
+            // Remove the punctuation (most words have none and are used as they are)
+            if (punctuated) {
+                cleaned.clear();
+                for (char c : word)
+                    if (s_byteClass[static_cast<unsigned char>(c)] != Punct)
+                        cleaned.push_back(c);
+                word = cleaned;
+            }
+
+            // Drop a trailing "'s"
+            if (word.size() > 2 && word[word.size() - 2] == '\'' && word.back() == 's')
+                word.remove_suffix(2);
+
+            callback(word, base + start);
+        }
+    }
+
+    /// @brief Finds where text can be split without cutting a word in two.
+    /// @param text The text.
+    /// @param pos The preferred split position.
+    /// @return The first whitespace position at or after pos (text.size() if there is none).
+    static size_t findWordBoundary(std::string_view text, size_t pos);
+
+private:
+
+    /// @brief Byte classes used by forEachWord().
+    enum ByteClass : uint8_t { Letter, Space, Punct };
+
+    /// @brief The class of every byte value (whitespace and punctuation as in the "C" locale).
+    static constexpr std::array<uint8_t, 256> s_byteClass = [] {
+        std::array<uint8_t, 256> classes{};
+        for (int c = 0; c < 256; ++c) {
+            if (c == ' ' || (c >= '\t' && c <= '\r'))
+                classes[c] = Space;
+            else if (c != '\'' && ((c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~')))
+                classes[c] = Punct;
+        }
+        return classes;
+    }();
+
+    /// @brief Counts a word whose hash is already known.
+    void add(std::string_view word, uint64_t hash, uint64_t position, uint64_t count);
+
+    /// @brief Doubles the table and reinserts every entry.
+    void grow();
+
+    /// @brief Copies a word into the arena.
+    /// @return A view of the copy, valid for the counter's lifetime.
+    std::string_view store(std::string_view word);
+
+    /// @brief The size of each arena block (longer words get a block of their own).
+    static constexpr size_t ArenaBlockSize = size_t(64) << 10;
+
+    /// @brief The hash table (a power-of-two number of slots, at most half full).
+    std::vector<Entry> m_slots;
+
+    /// @brief The number of used slots.
+    size_t m_size = 0;
+
+    /// @brief The sum of all counts.
+    uint64_t m_total = 0;
+
+    /// @brief The arena blocks holding the words.
+    std::vector<std::unique_ptr<char[]>> m_arena;
+
+    /// @brief The next free byte of the current arena block.
+    char *m_arenaCursor = nullptr;
+
+    /// @brief The unused bytes left in the current arena block.
+    size_t m_arenaFree = 0;
+};
@@ -1,19 +1,185 @@
-
 // ---------------------- System Header Includes ----------------------
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <optional>
+#include <cmath>
 
 // ---------------------- Class Header Includes ----------------------
 #include "File.h"
 #include "Utils.h"
 #include "CompressionTable.h"
+#include "Codec.h"
+#include "Archive.h"
+#include "TableCache.h"
+#include "TableGenerator.h"
 
 
 // ---------------------- Library Includes ----------------------
 #include "Ctxt/ctxt.h"
 
+// ---------------------- Helper Definitions ----------------------
+
+/// @brief Loads the compression table for the c and d modes.
+/// @param options The command line options; "--table=path" selects a CSV table instead of the built-in one.
+/// @param mode Whether the table will compress or decompress.
+/// @param csv Receives the CSV file if one is read (the table refers to it, so it must live as long).
+/// @param table Receives the table.
+/// @return False (after printing an error) if no table could be loaded.
+/// @note The built-in table needs no file I/O; './csv/table.csv' is only read if the program was built without one.
+/// @note A table from disk is loaded from its compiled (.tft) form when that is up to date, and compiled otherwise.
+static bool loadTable(std::unordered_map<std::string, std::string>& options, CompressionTable::Mode mode,
+                      std::optional<CSVFile>& csv, std::optional<CompressionTable>& table){
+
+    try {
+
+        // The table compiled into the program
+        if(!options.count("table") && CompressionTable::defaultImage() != nullptr){
+            table.emplace(mode);
+            return true;
+        }
+
+        // A table from disk: find out exactly which version of it is there
+        std::string path = options.count("table") ? options["table"] : "./csv/table.csv";
+        TableCache::Stamp stamp;
+        try {
+            stamp = TableCache::stampOf(path);
+        } catch (const std::exception &e) {
+            ctxt("\nError: Could not read '" + path + "'. Make sure it exists. (" + e.what() + ")\n", red, false, false, true);
+            return false;
+        }
+
+        // Use its compiled form if that was made from this exact version
+        std::string compiledPath = TableCache::pathFor(path);
+        CompressionTable::Image image{};
+        if(std::unique_ptr<MappedFile> map = TableCache::load(compiledPath, stamp, image)){
+            table.emplace(image, mode, std::move(map));
+            return true;
+        }
+
+        // Otherwise parse the CSV
+        csv.emplace(path);
+        try {
+            csv->read();
+        } catch (const std::exception &e) {
+            ctxt("\nError: Could not read '" + path + "'. Make sure it exists. (" + e.what() + ")\n", red, false, false, true);
+            return false;
+        }
+        table.emplace(*csv, mode);
+
+        // And compile it for the next run (best effort; e.g. the directory may be read-only)
+        try {
+            TableCache::write(*csv, stamp, compiledPath);
+        } catch (const std::exception &) {}
+    } catch (const std::exception &e) {
+        ctxt(std::string("\nError: Invalid compression table: ") + e.what() + "\n", red, false, false, true);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Reads the --parse option.
+/// @param options The command line options.
+/// @param parse Receives the parse (left unchanged if the option is absent).
+/// @return False (after printing an error) if the value is not a known parse.
+static bool readParse(std::unordered_map<std::string, std::string>& options, CompressionTable::Parse& parse){
+
+    // Nothing to read
+    if(!options.count("parse"))
+        return true;
+
+    // Match the name
+    if(options["parse"] == "greedy")
+        parse = CompressionTable::Greedy;
+    else if(options["parse"] == "optimal")
+        parse = CompressionTable::Optimal;
+    else if(options["parse"] == "longest")
+        parse = CompressionTable::LongestMatch;
+    else if(options["parse"] == "lazy")
+        parse = CompressionTable::LazyMatch;
+    else {
+        ctxt("\nError: Invalid value '" + options["parse"] + "' for --parse (expected 'greedy', 'optimal', 'longest' or 'lazy').\n", red, false, false, true);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Reads the --threads option.
+/// @param options The command line options.
+/// @param threads Receives the thread count (left unchanged if the option is absent).
+/// @return False (after printing an error) if the value is not a positive number.
+static bool readThreads(std::unordered_map<std::string, std::string>& options, unsigned& threads){
+
+    // Nothing to read
+    if(!options.count("threads"))
+        return true;
+
+    // At least one thread
+    try {
+        size_t used = 0;
+        unsigned long value = std::stoul(options["threads"], &used);
+        if(used == options["threads"].size() && value >= 1 && value <= 4096){
+            threads = static_cast<unsigned>(value);
+            return true;
+        }
+    } catch (const std::exception&) {}
+    ctxt("\nError: Invalid value '" + options["threads"] + "' for --threads (expected a thread count of at least 1).\n", red, false, false, true);
+    return false;
+}
+
+/// @brief Reads the --offset, --length and --lines options of the d mode.
+/// @param options The command line options.
+/// @param bytes Receives the byte range as {offset, length} if --offset or --length is given.
+/// @param lines Receives the line range as {first, last} (1 is the first line, both included) if --lines is given.
+/// @return False (after printing an error) if a value is not a valid number or range, or both kinds of range are given.
+static bool readRange(std::unordered_map<std::string, std::string>& options,
+                      std::optional<std::pair<uint64_t, uint64_t>>& bytes, std::optional<std::pair<uint64_t, uint64_t>>& lines){
+
+    // Reads a whole value as a number
+    auto number = [](const std::string& text, uint64_t& value){
+        try {
+            size_t used = 0;
+            value = std::stoull(text, &used);
+            return used == text.size() && text[0] != '-' && value < UINT64_MAX;
+        } catch (const std::exception&) {
+            return false;
+        }
+    };
+
+    // A byte range: from the offset (default the start) for the length (default the rest)
+    if(options.count("offset") || options.count("length")){
+        uint64_t offset = 0, length = UINT64_MAX;
+        if((options.count("offset") && !number(options["offset"], offset)) || (options.count("length") && !number(options["length"], length))){
+            ctxt("\nError: --offset and --length expect a number of bytes.\n", red, false, false, true);
+            return false;
+        }
+        bytes.emplace(offset, length);
+    }
+
+    // A line range: a single line, or the first and last lines joined by '-'
+    if(options.count("lines")){
+        const std::string& range = options["lines"];
+        size_t dash = range.find('-');
+        uint64_t first = 0, last = 0;
+        bool valid = dash == std::string::npos ? number(range, first) && number(range, last)
+                                               : number(range.substr(0, dash), first) && number(range.substr(dash + 1), last);
+        if(!valid || first == 0 || last < first){
+            ctxt("\nError: Invalid value '" + range + "' for --lines (expected a line number or a range such as 10-20; the first line is 1).\n", red, false, false, true);
+            return false;
+        }
+        lines.emplace(first, last);
+    }
+
+    // One kind of range at a time
+    if(bytes && lines){
+        ctxt("\nError: --lines cannot be combined with --offset or --length.\n", red, false, false, true);
+        return false;
+    }
+    return true;
+}
+
 // ---------------------- Main Definition ----------------------
 int main(int argc, char *argv[]){
 
@@ -22,6 +188,19 @@ int main(int argc, char *argv[]){
     // for(int i = 0; i<100; i++)
     //     std::cout<<test.getData()->at(i);return 0;
 
+    // Pull out the --key=value options so the positional arguments keep their usual places
+    std::unordered_map<std::string, std::string> options = Utils::extractOptions(argc, argv);
+
+    // Reject options nobody would read
+    const std::string knownOptions[] = {"parse", "table", "top", "error", "words", "max-bits", "entries", "threads", "offset", "length", "lines"};
+    for(const auto& option : options){
+        if(std::find(std::begin(knownOptions), std::end(knownOptions), option.first) == std::end(knownOptions)){
+            ctxt("\nError: Unknown option '--" + option.first + "'.\n", red, false, false, true);
+            Utils::printUsage(argv);
+            return 1;
+        }
+    }
+
     // If the program was not run with exactly 2, 3, or 4 arguments, print usage message and exit
     if(argc != 4 && argc != 3 && argc != 2){
         Utils::printUsage(argv);
@@ -46,6 +225,9 @@ int main(int argc, char *argv[]){
         Utils::testCharFreqs();
         Utils::testWordFreqs();
         Utils::testAccuracy();
+        Utils::testArchive();
+        Utils::testStreaming();
+        Utils::testTableCodes();
 
         // If extraneous arguments were provided, warn the user
         if(argc != 2){
@@ -56,7 +238,7 @@ int main(int argc, char *argv[]){
     }
 
     // Verify that the mode argument is valid
-    if(mode != "c" && mode != "d" && mode != "gc" && mode != "gw" && mode != "acc"){
+    if(mode != "c" && mode != "d" && mode != "gc" && mode != "gw" && mode != "gt" && mode != "tr" && mode != "acc" && mode != "verify"){
         ctxt("\nError: Invalid mode '"+mode+"'.\n", dark_red, false, false, false);
         Utils::printUsage(argv);
 
@@ -90,34 +272,6 @@ int main(int argc, char *argv[]){
             return 1;
         }
 
-        // Create a TextFile object for the input file
-        TextFile txtFile(inputFilePath);
-
-        // Read the content of the text file
-        try {
-            txtFile.read();
-        } catch (const std::exception &e) {
-            ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
-            return 1;
-        }
-
-        // Normalize the text file in memory
-        // (changes smart quotes and apostrophes to straight ones, em-dashes to -, etc.)
-        txtFile.normalizePunctuation();
-
-        // Reset stringstream position to the beginning
-        txtFile.getData()->clear();
-        txtFile.getData()->seekg(0, std::ios::beg);
-
-        // Check if table.csv exists in the csv directory
-        CSVFile csvCompTable("./csv/table.csv");
-        try {
-            csvCompTable.read();
-        } catch (const std::exception &e) {
-            ctxt(std::string("\nError: Could not read './csv/table.csv'. Make sure it exists in the csv directory. (")+e.what()+")\n", red, false, false, true);
-            return 1;
-        }
-
         // Calculate the output file path
         std::string outputFilePath;
         if(argc == 4){
@@ -129,68 +283,67 @@ int main(int argc, char *argv[]){
         // Default output path
         else outputFilePath = inputFileNameNoExt + ".bin";
 
-        CompressionTable table(csvCompTable, CompressionTable::Compress);
-
-        // Stores the final binary vector to be written to the output file
-        std::vector<bool> finalBinary;
-
-        // Keep track of current word
-        std::string currentWord = "";
+        // Load the compression table (the built-in one unless --table says otherwise)
+        std::optional<CSVFile> csvCompTable;
+        std::optional<CompressionTable> loadedTable;
+        if(!loadTable(options, CompressionTable::Compress, csvCompTable, loadedTable))
+            return 1;
+        CompressionTable& table = *loadedTable;
 
-        // Read file content character by character
-        char c;
-        while(txtFile.getData()->get(c)){
+        // Pick how words are split into table entries
+        CompressionTable::Parse parse = CompressionTable::Greedy;
+        if(!readParse(options, parse))
+            return 1;
+        table.setParse(parse);
 
-            // Check if the selected character is a space or newline
-            if(c == ' ' || c == '\n'){
+        // Blocks are encoded on every core unless told otherwise (the file is the same either way)
+        unsigned threads = 0;
+        if(!readThreads(options, threads))
+            return 1;
 
-                // Attempt to map the current word to binary
-                try {
+        // Large inputs go through the bounded-memory pipeline (same output, constant memory)
+        if(Codec::shouldStream(inputFilePath)){
+            Codec::Stats stats;
+            try {
+                stats = Codec::compressStream(inputFilePath, outputFilePath, table, threads);
+            } catch (const std::exception &e) {
+                ctxt(std::string("\nError compressing file: ") + e.what() + "\n", red, false, false, true);
+                return 1;
+            }
 
-                    // Append the space/newline char to the end of the mapping
-                    std::vector<bool> tmp = table.mapStrToBin(currentWord+std::string(1,c));
+            // Notify the user of the successful compression
+            ctxt(std::string("\nSuccessfully compressed '") + inputFileName + "' to '" + outputFilePath + "'.\n", green, false, false, true);
 
-                    // Insert the binary to the final boolean vector
-                    finalBinary.insert(finalBinary.end(), tmp.begin(), tmp.end());
-                    
-                } catch (std::exception &e){
-                    ctxt(std::string("\nError mapping word to binary: ") + e.what(), red, false, false, true);
-                    return 1;
-                }
+            // Display the percent reduction
+            double reduction = Utils::genPercentReduction(stats.textBytes, stats.payloadBits);
+            ctxt(std::string("Compression reduced file size by ") + std::to_string(reduction) + "%.\n", magenta, false, false, true);
 
-                // Clear the word
-                currentWord.clear();
-            }
-            else {
-                
-                // Append the character to the built string
-                currentWord+=c;
-            }
+            return 0;
         }
 
-        // handle the last word if it exists
-        if(!currentWord.empty()){
-
-            // Attempt to map the final word to binary
-            try {
-                std::vector<bool> tmp = table.mapStrToBin(currentWord);
+        // Create a TextFile object for the input file
+        TextFile txtFile(inputFilePath);
 
-                // Insert the binary to the final boolean vector
-                finalBinary.insert(finalBinary.end(), tmp.begin(), tmp.end());
-                
-            } catch (std::exception &e){
-                ctxt(std::string("\nError mapping final word to binary: ") + e.what(), red, false, false, true);
-                return 1;
-            }
+        // Read the content of the text file
+        try {
+            txtFile.readMapped();
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
+            return 1;
         }
-                
-        // Write the binary vector to the file
-        BinaryFile binOut(outputFilePath);
-        binOut.setData(&finalBinary);
 
+        // Normalize the text file in memory
+        // (changes smart quotes and apostrophes to straight ones, em-dashes to -, etc.)
+        // The mapping is only copied if something actually changes
+        txtFile.normalizePunctuation();
+
+        // Encode the whole text into a version 2 file, blocks in parallel (each word together with the space or newline that ends it)
+        ArchiveWriter::Stats written;
         try {
-            binOut.write();
-        } catch (const std::exception &e) {
+            ArchiveWriter binOut(outputFilePath, table, threads);
+            binOut.write(txtFile.getView());
+            written = binOut.finish();
+        } catch (std::exception &e){
             ctxt(std::string("\nError writing to binary file: ") + e.what(), red, false, false, true);
             return 1;
         }
@@ -199,7 +352,7 @@ int main(int argc, char *argv[]){
         ctxt(std::string("\nSuccessfully compressed '") + inputFileName + "' to '" + outputFilePath + "'.\n", green, false, false, true);
 
         // Calculate the percent reduction
-        double reduction = Utils::genPercentReduction(&txtFile, &binOut);
+        double reduction = Utils::genPercentReduction(written.textBytes, written.payloadBits);
 
         // Display the percent reduction
         ctxt(std::string("Compression reduced file size by ") + std::to_string(reduction) + "%.\n", magenta, false, false, true);
@@ -220,26 +373,6 @@ int main(int argc, char *argv[]){
             return 1;
         }
 
-        // Create a BinaryFile object for the input file
-        BinaryFile binFile(inputFilePath);
-
-        // Read the content of the binary file
-        try {
-            binFile.read();
-        } catch (const std::exception &e) {
-            ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
-            return 1;
-        }
-
-        // Check if table.csv exists in the current directory
-        CSVFile csvCompTable("./csv/table.csv");
-        try {
-            csvCompTable.read();
-        } catch (const std::exception &e) {
-            ctxt(std::string("\nError: Could not read './csv/table.csv'. Make sure it exists in the csv directory.\n"), red, false, false, true);
-            return 1;
-        }
-
         // Calculate the output file path
         std::string outputFilePath;
         if(argc == 4)
@@ -250,67 +383,107 @@ int main(int argc, char *argv[]){
         // Default file path
         else outputFilePath = inputFileNameNoExt + ".txt";
 
-        // Create our mapping table object in decompression mode
-        CompressionTable table(csvCompTable, CompressionTable::Decompress);
+        // Create our mapping table object in decompression mode (the built-in one unless --table says otherwise)
+        std::optional<CSVFile> csvCompTable;
+        std::optional<CompressionTable> loadedTable;
+        if(!loadTable(options, CompressionTable::Decompress, csvCompTable, loadedTable))
+            return 1;
+        CompressionTable& table = *loadedTable;
 
-        // Create our output text file object
-        TextFile outFile(outputFilePath);
+        // Blocks are decoded on every core unless told otherwise
+        unsigned threads = 0;
+        if(!readThreads(options, threads))
+            return 1;
 
-        // Iterate through the binary bits one by one
-        bool one, two;
-        unsigned int count = 0;
-        std::vector<bool> tmp;
-        while(count < binFile.getData()->size()){
+        // Only part of the text may be wanted
+        std::optional<std::pair<uint64_t, uint64_t>> byteRange, lineRange;
+        if(!readRange(options, byteRange, lineRange))
+            return 1;
 
-            // Add the current bit
-            tmp.push_back(binFile.getData()->at(count));
+        // A range is found in the block index, and only the blocks that hold it are decoded
+        if(byteRange || lineRange){
+            BinaryFile binFile(inputFilePath);
+            size_t written = 0;
+            try {
+                binFile.readMapped(MappedFile::Normal);
+                if(!binFile.isArchive()){
+                    ctxt("\nError: --offset, --length and --lines need a file with a block index (compressed by this version).\n", red, false, false, true);
+                    return 1;
+                }
+                Archive::Index index = Archive::readIndex(binFile.getPayload());
+                Archive::checkTable(index, table);
+
+                // Turn a line range into a byte range (each end decodes at most one block)
+                uint64_t offset = byteRange ? byteRange->first : Archive::findLine(table, index, binFile.getPayload(), lineRange->first);
+                uint64_t length = byteRange ? byteRange->second : Archive::findLine(table, index, binFile.getPayload(), lineRange->second + 1) - offset;
+                std::string text = Archive::decodeRange(table, index, binFile.getPayload(), offset, length, threads);
+
+                // Write just that part out
+                TextFile outFile(outputFilePath);
+                written = text.size();
+                outFile.getData()->str(std::move(text));
+                outFile.write();
+            } catch (const std::exception &e) {
+                ctxt(std::string("\nError decompressing range: ") + e.what() + "\n", red, false, false, true);
+                return 1;
+            }
 
-            // If a short representation
-            if(binFile.getData()->at(count)){
+            // Success!
+            ctxt(std::string("\nSuccessfully decompressed ") + std::to_string(written) + " bytes of '" + inputFileName + "' to '" + outputFilePath + "'.\n", green, false, false, true);
+            return 0;
+        }
 
-                // Grab the next 2 bits
-                one = binFile.getData()->at(++count);
-                tmp.push_back(one);
-                two = binFile.getData()->at(++count);
-                tmp.push_back(two);
+        // Large inputs go through the bounded-memory pipeline (same output, constant memory)
+        if(Codec::shouldStream(inputFilePath)){
+            try {
+                Codec::decompressStream(inputFilePath, outputFilePath, table, threads);
+            } catch (const std::exception &e) {
+                ctxt(std::string("\nError decompressing file: ") + e.what() + "\n", red, false, false, true);
+                return 1;
+            }
 
-                // If both bits are 0, then we have an extra short representation
-                if(!one && !two){}// Stop here!
+            // Success!
+            ctxt(std::string("\nSuccessfully decompressed '") + inputFileName + "' to '" + outputFilePath + "'.\n", green, false, false, true);
+            return 0;
+        }
 
-                // Otherwise, grab the next bit
-                else tmp.push_back(binFile.getData()->at(++count));
-            }
+        // Create a BinaryFile object for the input file
+        BinaryFile binFile(inputFilePath);
 
-            // We have a long representation
-            else {
+        // Read the content of the binary file
+        try {
+            binFile.readMapped();
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
 
-                // Grab the next 6 bits
-                for(int i = 0; i<6; i++)
-                    tmp.push_back(binFile.getData()->at(++count));
-            }
 
-            // Stream our temporary representation to the file object's data stream
-            std::string tmpString;
-            try {
+        // Create our output text file object
+        TextFile outFile(outputFilePath);
 
-                // Attempt to map the binary to a string
-                tmpString = table.mapBinToStr(tmp);
+        // Decode the whole stream through the lookup table (the blocks of a version 2 file in parallel, each into its slice of the text)
+        std::string decoded;
+        try {
+            if(binFile.isArchive()){
+                Archive::Index index = Archive::readIndex(binFile.getPayload());
+                Archive::checkTable(index, table);
+                decoded.resize(index.textBytes);
+                Archive::decodeBlocks(table, index.blocks, binFile.getPayload().data(), 0, decoded.data(), threads);
             }
-            catch (const std::exception &e){
-                ctxt(std::string("Error mapping Binary to String: ")+e.what(), red, true, false, true);
-                return 1;
+            else {
+                BitReader reader(binFile.getPayload().data(), binFile.getBitCount());
+                table.decode(reader, decoded);
             }
-
-            // Actually stream the binary to the file object
-            // Note that we did not write to the file yet! This is still in memory
-            *outFile.getData() << tmpString;
-            
-            // Clear our temporary vector
-            tmp.clear();
-
-            // Increment our index
-            count++;
         }
+        catch (const std::exception &e){
+            ctxt(std::string("Error mapping Binary to String: ")+e.what(), red, true, false, true);
+            return 1;
+        }
+
+        // Hand the text to the file object's data stream
+        // Note that we did not write to the file yet! This is still in memory
+        outFile.getData()->str(std::move(decoded));
 
         // Attempt to write out the file
         try {
@@ -342,9 +515,9 @@ int main(int argc, char *argv[]){
         // Create a TextFile object for the input file
         TextFile txtFile(inputFilePath);
 
-        // Attempt to read the content of the text file
+        // Map the text file (the histogram reads it in place)
         try {
-            txtFile.read();
+            txtFile.readMapped();
         } catch (const std::exception &e) {
             ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
             return 1;
@@ -374,6 +547,9 @@ int main(int argc, char *argv[]){
             // Make sure delimeter is properly escaped
             else if(pair.first == ',') charStr = "\",\"";
 
+            // Quotes are escaped inside quotes
+            else if(pair.first == '"') charStr = "\"\\\"\"";
+
             // Insert the character
             freqData.emplace_back(std::vector<std::string>{charStr, std::to_string(pair.second)});
         }
@@ -414,37 +590,94 @@ int main(int argc, char *argv[]){
         // Create a TextFile object for the input file
         TextFile txtFile(inputFilePath);
 
-        // Attempt to read the content of the text file
+        // Map the text file (the words are counted in place)
         try {
-            txtFile.read();
+            txtFile.readMapped();
         } catch (const std::exception &e) {
             ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
             return 1;
         }
 
-        // Generate word frequencies
-        auto freqs = Utils::genWordFreqs(&txtFile);
-
         // Prepare to write frequencies to a CSV file
         std::string outputFilePath = inputFileNameNoExt + "_word_freqs.csv";
         CSVFile freqFile(outputFilePath);
         std::vector<std::vector<std::string>> freqData;
 
-        // Prepare data for CSV
-        freqData.emplace_back(std::vector<std::string>{"Word", "Frequency (%)"});
+        // With --top, only the head of the distribution is estimated, in fixed memory
+        if(options.count("top")){
 
-        // Populate frequency data
-        for(const auto& pair : *freqs){
+            // Read the number of words to report and, optionally, the largest acceptable error (in percent)
+            size_t k = 0, counters = 0;
+            try {
+                k = std::stoull(options["top"]);
+                counters = 4 * std::min<size_t>(k, UINT32_MAX);
 
-            // Get the string for the word
-            std::string wordStr = pair.first;
+                // A counter per error-sized share of the words (never fewer than k)
+                if(options.count("error")){
+                    double error = std::stod(options["error"]);
+                    counters = error > 0.0 && error <= 100.0 ? std::max(k, static_cast<size_t>(std::ceil(100.0 / error))) : 0;
+                }
+            } catch (const std::exception &) {
+                k = 0;
+            }
+            if(k == 0 || counters == 0 || counters > UINT32_MAX){
+                ctxt("\nError: --top expects a positive word count and --error a positive percentage.\n", red, false, false, true);
+                return 1;
+            }
+
+            // Estimate the top words
+            double maxOverestimate = 0.0;
+            auto freqs = Utils::genTopWordFreqs(&txtFile, k, counters, maxOverestimate);
 
-            // Make sure the delimiter is properly escaped
-            if(wordStr.find(',') != std::string::npos)
-                wordStr = "\"" + wordStr + "\"";
-            
-            // Insert the word
-            freqData.emplace_back(std::vector<std::string>{wordStr, std::to_string(pair.second)});
+            // Prepare data for CSV (the same columns as a full run, so gt reads it the same way)
+            freqData.emplace_back(std::vector<std::string>{"Word", "Frequency (%)"});
+
+            // Populate frequency data
+            for(const auto& [word, frequency] : *freqs){
+
+                // Make sure the delimiter is properly escaped
+                std::string wordStr = word;
+                if(wordStr.find(',') != std::string::npos)
+                    wordStr = "\"" + wordStr + "\"";
+
+                // Insert the word
+                freqData.emplace_back(std::vector<std::string>{wordStr, std::to_string(frequency)});
+            }
+
+            // Clean up allocated memory
+            delete freqs;
+
+            // State the guarantee
+            ctxt("\nTracked " + std::to_string(counters) + " words at a time: every estimate is at most " + std::to_string(100.0 / counters) +
+                "% above the true frequency, and every word more frequent than that is counted.\n", yellow, false, false, true);
+            ctxt("The reported estimates are at most " + std::to_string(maxOverestimate) + "% above their words' true frequencies.\n", yellow, false, false, true);
+        }
+
+        // Otherwise every word is counted exactly
+        else {
+
+            // Generate word frequencies
+            auto freqs = Utils::genWordFreqs(&txtFile);
+
+            // Prepare data for CSV
+            freqData.emplace_back(std::vector<std::string>{"Word", "Frequency (%)"});
+
+            // Populate frequency data
+            for(const auto& pair : *freqs){
+
+                // Get the string for the word
+                std::string wordStr = pair.first;
+
+                // Make sure the delimiter is properly escaped
+                if(wordStr.find(',') != std::string::npos)
+                    wordStr = "\"" + wordStr + "\"";
+                
+                // Insert the word
+                freqData.emplace_back(std::vector<std::string>{wordStr, std::to_string(pair.second)});
+            }
+
+            // Clean up allocated memory
+            delete freqs;
         }
 
         // Set data to the file object
@@ -455,17 +688,211 @@ int main(int argc, char *argv[]){
             freqFile.write();
         } catch (const std::exception &e) {
             ctxt(std::string("\nError writing frequency file: ") + e.what() + "\n", red, false, false, true);
-            delete freqs;
             return 1;
         }
 
-        // Clean up allocated memory
-        delete freqs; 
-
         // Success!
         ctxt(std::string("\nSuccessfully generated word frequencies and wrote to '") + outputFilePath + "'.\n", green, false, false, true);
     }
 
+    // Handle generate table mode
+    else if(mode == "gt"){
+
+        // If extraneous arguments were provided, warn the user
+        if(argc > 4){
+            ctxt("\nWarning: Extraneous arguments provided with 'gt' mode. They have been ignored.\n", yellow, false, false, true);
+        }
+
+        // Read the number of word entries and the code length limit
+        size_t words = TableGenerator::DefaultWords;
+        unsigned maxBits = CompressionTable::MaxCodeLength;
+        try {
+            if(options.count("words"))
+                words = std::stoull(options["words"]);
+            if(options.count("max-bits"))
+                maxBits = static_cast<unsigned>(std::stoul(options["max-bits"]));
+        } catch (const std::exception &) {
+            maxBits = 0;
+        }
+        if(maxBits == 0 || maxBits > CompressionTable::MaxCodeLength){
+            ctxt("\nError: --words expects a word count and --max-bits a code length from 1 to " + std::to_string(CompressionTable::MaxCodeLength) + ".\n", red, false, false, true);
+            return 1;
+        }
+
+        // Weigh the entries: by encoding a text, or from 'gc'/'gw' output
+        std::vector<TableGenerator::Entry> entries;
+        bool fromText = inputFileExt == "txt";
+        try {
+            if(fromText){
+
+                // Map and normalize the text exactly as compression would
+                if(argc == 4)
+                    ctxt("\nWarning: Only one .txt input is used in 'gt' mode. The second one has been ignored.\n", yellow, false, false, true);
+                TextFile txtFile(inputFilePath);
+                txtFile.readMapped();
+                txtFile.normalizePunctuation();
+                entries = TableGenerator::weighText(txtFile.getView(), words);
+            }
+            else if(inputFileExt == "csv"){
+
+                // Tell the character frequencies from the word frequencies by their header
+                std::optional<CSVFile> chars, wordFreqs;
+                for(int arg = 2; arg < std::min(argc, 4); arg++){
+                    CSVFile probe(argv[arg]);
+                    probe.readViews();
+                    bool isChars = probe.getRowCount() > 0 && !probe.getRow(0).empty() && probe.getRow(0)[0] == "Character";
+                    (isChars ? chars : wordFreqs).emplace(argv[arg]);
+                }
+                entries = TableGenerator::weighFrequencies(chars ? &*chars : nullptr, wordFreqs ? &*wordFreqs : nullptr, words);
+            }
+            else {
+                ctxt("\nError: Generate table mode requires a .txt input file, or 'gc' and/or 'gw' .csv output.\n", red, false, false, true);
+                return 1;
+            }
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError reading input file: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Assign the codes
+        uint64_t payloadBits = 0;
+        std::vector<std::vector<std::string>> tableData;
+        try {
+            tableData = TableGenerator::buildRows(entries, maxBits, payloadBits);
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError generating table: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Write the table
+        std::string outputFilePath = inputFileNameNoExt + "_table.csv";
+        CSVFile tableFile(outputFilePath, &tableData);
+        try {
+            tableFile.write();
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError writing table file: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Success!
+        ctxt(std::string("\nSuccessfully generated a ") + std::to_string(tableData.size()) + "-entry table and wrote to '" + outputFilePath + "'.\n", green, false, false, true);
+
+        // A text was actually encoded, so its compressed size is known
+        if(fromText)
+            ctxt("Compressing '" + inputFileName + "' with it takes about " + std::to_string((payloadBits + 7) / 8) + " bytes (use --table=" + outputFilePath + ").\n", yellow, false, false, true);
+    }
+
+    // Handle train table mode
+    else if(mode == "tr"){
+
+        // If extraneous arguments were provided, warn the user
+        if(argc != 3){
+            ctxt("\nWarning: Extraneous arguments provided with 'tr' mode. They have been ignored.\n", yellow, false, false, true);
+        }
+
+        // Make sure the input file is a .txt file
+        if(inputFileExt != "txt"){
+            ctxt("\nError: Train table mode requires a .txt input file.\n", red, false, false, true);
+            return 1;
+        }
+
+        // Read the entry budget, the code length limit and the parse the table is meant for
+        size_t entries = TableGenerator::DefaultEntries;
+        unsigned maxBits = CompressionTable::MaxCodeLength;
+        CompressionTable::Parse parse = CompressionTable::Greedy;
+        try {
+            if(options.count("entries"))
+                entries = std::stoull(options["entries"]);
+            if(options.count("max-bits"))
+                maxBits = static_cast<unsigned>(std::stoul(options["max-bits"]));
+        } catch (const std::exception &) {
+            maxBits = 0;
+        }
+        if(maxBits == 0 || maxBits > CompressionTable::MaxCodeLength){
+            ctxt("\nError: --entries expects an entry count and --max-bits a code length from 1 to " + std::to_string(CompressionTable::MaxCodeLength) + ".\n", red, false, false, true);
+            return 1;
+        }
+        if(!readParse(options, parse))
+            return 1;
+
+        // Map and normalize the text exactly as compression would, then mine it
+        uint64_t payloadBits = 0;
+        std::vector<std::vector<std::string>> tableData;
+        try {
+            TextFile txtFile(inputFilePath);
+            txtFile.readMapped();
+            txtFile.normalizePunctuation();
+            tableData = TableGenerator::buildRows(TableGenerator::mineText(txtFile.getView(), entries, parse, maxBits), maxBits, payloadBits);
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError training table: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Write the table
+        std::string outputFilePath = inputFileNameNoExt + "_table.csv";
+        CSVFile tableFile(outputFilePath, &tableData);
+        try {
+            tableFile.write();
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError writing table file: ") + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Success!
+        ctxt(std::string("\nSuccessfully trained a ") + std::to_string(tableData.size()) + "-entry table and wrote to '" + outputFilePath + "'.\n", green, false, false, true);
+        ctxt("Compressing '" + inputFileName + "' with it takes about " + std::to_string((payloadBits + 7) / 8) + " bytes (use --table=" + outputFilePath +
+            (options.count("parse") ? " --parse=" + options["parse"] : std::string()) + ").\n", yellow, false, false, true);
+    }
+
+    // Handle verify mode
+    else if(mode == "verify"){
+
+        // If extraneous arguments were provided, warn the user
+        if(argc != 3){
+            ctxt("\nWarning: Extraneous arguments provided with 'verify' mode. They have been ignored.\n", yellow, false, false, true);
+        }
+
+        // Make sure that the input file is a .bin file
+        if(inputFileExt != "bin"){
+            ctxt("\nError: Verify mode requires a .bin input file.\n", red, false, false, true);
+            return 1;
+        }
+
+        // Blocks are checked on every core unless told otherwise
+        unsigned threads = 0;
+        if(!readThreads(options, threads))
+            return 1;
+
+        // Map the file and check its header and index
+        BinaryFile binFile(inputFilePath);
+        Archive::Index index;
+        try {
+            binFile.readMapped();
+            if(!binFile.isArchive()){
+                ctxt("\nError: '" + inputFileName + "' has no checksums to verify (it was compressed by an older version).\n", red, false, false, true);
+                return 1;
+            }
+            index = Archive::readIndex(binFile.getPayload());
+        } catch (const std::exception &e) {
+            ctxt(std::string("\nError: '") + inputFileName + "' is damaged: " + e.what() + "\n", red, false, false, true);
+            return 1;
+        }
+
+        // Then every block's checksum, without decoding anything
+        std::vector<size_t> damaged = Archive::verify(index, binFile.getPayload(), threads);
+        if(!damaged.empty()){
+            ctxt("\nError: " + std::to_string(damaged.size()) + " of " + std::to_string(index.blocks.size()) + " blocks of '" + inputFileName + "' are damaged.\n", red, false, false, true);
+            for(size_t i = 0; i < std::min<size_t>(damaged.size(), 10); i++){
+                const Archive::Block& block = index.blocks[damaged[i]];
+                ctxt("  Block " + std::to_string(damaged[i]) + ": text bytes " + std::to_string(block.sourceOffset) + " to " + std::to_string(block.sourceOffset + block.sourceBytes) + "\n", yellow, false, false, false);
+            }
+            return 1;
+        }
+
+        // Intact!
+        ctxt("\n'" + inputFileName + "' is intact (" + std::to_string(index.blocks.size()) + " blocks, " + std::to_string(index.textBytes) + " bytes of text).\n", green, false, false, true);
+    }
+
     // Handle accuracy comparison mode
     else if(mode == "acc"){
 
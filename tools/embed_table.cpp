@@ -0,0 +1,146 @@
+// Build step: turns a compression table CSV into DefaultTable.h, a header of constexpr lookup arrays
+// that CompressionTable can use in place without reading or parsing anything at run time.
+//
+// Usage: embed_table <table.csv> <DefaultTable.h>
+
+// ---------------------- Project Includes ----------------------
+#include "CompressionTable.h"
+#include "File.h"
+
+// ---------------------- System Includes ----------------------
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <span>
+
+// The generator is what produces the built-in table, so it runs without one (this replaces DefaultTable.cpp)
+const CompressionTable::Image* CompressionTable::defaultImage() {
+    return nullptr;
+}
+
+/// @brief Writes a byte as a character literal.
+/// @param out The stream to write to.
+/// @param c The byte.
+static void writeChar(std::ostream& out, char c) {
+    out << "'\\" << std::oct << static_cast<unsigned>(static_cast<uint8_t>(c)) << std::dec << "'";
+}
+
+/// @brief Writes a code as an aggregate initializer.
+/// @param out The stream to write to.
+/// @param code The code.
+static void writeCode(std::ostream& out, CompressionTable::Code code) {
+    out << "{" << code.bits << "u, " << static_cast<unsigned>(code.length) << "}";
+}
+
+/// @brief Writes a span of integers as a constexpr array.
+/// @param out The stream to write to.
+/// @param type The element type to declare.
+/// @param name The array name.
+/// @param values The elements.
+template <typename T>
+static void writeArray(std::ostream& out, const char* type, const char* name, std::span<const T> values) {
+    out << "    inline constexpr " << type << " " << name << "[] = {";
+    for (size_t i = 0; i < values.size(); ++i)
+        out << (i % 16 == 0 ? "\n        " : " ") << values[i] << ",";
+    out << "\n    };\n\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <table.csv> <DefaultTable.h>\n";
+        return 1;
+    }
+
+    try {
+
+        // Build the table both ways; each mode only fills in its own lookup tables
+        CSVFile csv(argv[1]);
+        csv.read();
+        CompressionTable encoder(csv, CompressionTable::Compress);
+        CompressionTable decoder(csv, CompressionTable::Decompress);
+        CompressionTable::Image enc = encoder.image();
+        CompressionTable::Image dec = decoder.image();
+        if (enc.symbols.empty())
+            throw std::runtime_error("the table is empty");
+
+        // Generate into memory first so a failure never leaves a half-written header behind
+        std::ostringstream out;
+        out << "// Generated from " << argv[1] << " by tools/embed_table.cpp. Do not edit.\n"
+            << "#pragma once\n\n"
+            << "// ---------------------- Project Includes ----------------------\n"
+            << "#include \"CompressionTable.h\"\n\n"
+            << "namespace DefaultTable {\n\n";
+
+        // Entries and their text
+        out << "    inline constexpr CompressionTable::Symbol symbols[] = {\n";
+        for (const CompressionTable::Symbol& symbol : enc.symbols) {
+            out << "        {" << symbol.offset << "u, " << symbol.length << "u, ";
+            writeCode(out, symbol.code);
+            out << "},\n";
+        }
+        out << "    };\n\n";
+
+        out << "    inline constexpr char symbolText[] = {";
+        for (size_t i = 0; i < enc.symbolText.size(); ++i) {
+            out << (i % 16 == 0 ? "\n        " : " ");
+            writeChar(out, enc.symbolText[i]);
+            out << ",";
+        }
+        out << "\n    };\n\n";
+
+        // Single-byte codes
+        out << "    inline constexpr CompressionTable::Code byteCodes[256] = {";
+        for (size_t i = 0; i < enc.byteCodes.size(); ++i) {
+            out << (i % 8 == 0 ? "\n        " : " ");
+            writeCode(out, enc.byteCodes[i]);
+            out << ",";
+        }
+        out << "\n    };\n\n";
+
+        // Decoder
+        out << "    inline constexpr std::array<int32_t, 2> decodeTrie[] = {";
+        for (size_t i = 0; i < dec.decodeTrie.size(); ++i)
+            out << (i % 8 == 0 ? "\n        " : " ") << "{" << dec.decodeTrie[i][0] << ", " << dec.decodeTrie[i][1] << "},";
+        out << "\n    };\n\n";
+
+        out << "    inline constexpr CompressionTable::DecodeEntry decodeTable[] = {\n";
+        for (const CompressionTable::DecodeEntry& entry : dec.decodeTable) {
+            out << "        {{";
+            for (unsigned i = 0; i < entry.textLength; ++i) {
+                writeChar(out, entry.text[i]);
+                out << (i + 1 < entry.textLength ? ", " : "");
+            }
+            out << "}, " << static_cast<unsigned>(entry.textLength) << ", " << static_cast<unsigned>(entry.bits) << "},\n";
+        }
+        out << "    };\n\n";
+
+        // Encoder
+        writeArray(out, "uint16_t", "matchClass", std::span<const uint16_t>(enc.matchClass));
+        writeArray(out, "int32_t", "matchNext", enc.matchNext);
+        writeArray(out, "int32_t", "matchOut", enc.matchOut);
+        writeArray(out, "int32_t", "matchShorter", enc.matchShorter);
+        writeArray(out, "uint32_t", "matchDepth", enc.matchDepth);
+
+        // The image CompressionTable is built from
+        out << "    inline constexpr CompressionTable::Image image{\n"
+            << "        symbols, std::string_view(symbolText, sizeof(symbolText)), byteCodes,\n"
+            << "        decodeTrie, decodeTable, " << dec.decodeMargin << "u,\n"
+            << "        matchClass, " << enc.matchClassCount << "u, matchNext, matchOut, matchShorter, matchDepth\n"
+            << "    };\n\n"
+            << "}\n";
+
+        // Write the header
+        std::ofstream file(argv[2], std::ios::out | std::ios::binary);
+        file << out.str();
+        file.close();
+        if (file.fail())
+            throw std::runtime_error(std::string("could not write ") + argv[2]);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "embed_table: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}